@@ -0,0 +1,52 @@
+TARGET = SpriteLoader
+
+QT       += core gui concurrent network
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++11
+
+# The following define makes your compiler emit warnings if you use
+# any Qt feature that has been marked deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# You can also make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+# You can also select to disable deprecated APIs only up to a certain version of Qt.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    main.cpp \
+    mainwindow.cpp \
+    spritebrowsermodel.cpp \
+    spriteserver.cpp \
+    spritewatcher.cpp
+
+HEADERS += \
+    mainwindow.h \
+    spritebrowsermodel.h \
+    spriteserver.h \
+    spritewatcher.h
+
+FORMS += \
+    mainwindow.ui
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../libspriteloader/release/ -lspriteloader
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../libspriteloader/debug/ -lspriteloader
+else:unix: LIBS += -L$$OUT_PWD/../libspriteloader/ -lspriteloader
+
+INCLUDEPATH += $$PWD/../libspriteloader
+DEPENDPATH += $$PWD/../libspriteloader
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../libspriteloader/release/libspriteloader.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../libspriteloader/debug/libspriteloader.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../libspriteloader/release/spriteloader.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../libspriteloader/debug/spriteloader.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../libspriteloader/libspriteloader.a
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,99 @@
+#include "mainwindow.h"
+#include "spriteserver.h"
+#include "batchscheduler.h"
+#include "spriteeditor.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QFile>
+#include <cstdio>
+#include <cstring>
+
+#define DEFAULT_SERVER_NAME "spriteloader"
+#define BATCH_CONCURRENT_LOADS 2
+#define BATCH_CONCURRENT_JOBS 4
+
+// Runs every job in the job file and reports each result, returns non-zero if any failed.
+static int runBatch(QString jobFilename)
+{
+    QFile jobFile(jobFilename);
+    if (!jobFile.open(QIODevice::ReadOnly)) {
+        qCritical() << "Unable to read" << jobFilename;
+        return 1;
+    }
+    std::vector<BatchJob> jobs;
+    if (!BatchScheduler::parseJobs(jobFile.readAll(), &jobs)) {
+        qCritical() << "Invalid job file" << jobFilename;
+        return 1;
+    }
+    jobFile.close();
+
+    BatchScheduler scheduler(BATCH_CONCURRENT_LOADS, BATCH_CONCURRENT_JOBS);
+    std::vector<BatchResult> results = scheduler.run(jobs);
+    int failedCount = 0;
+    for (uint32_t i = 0; i < results.size(); i++) {
+        if (results[i].result == SER_SUCCESS) {
+            qInfo().noquote() << QString("Job %1 (%2 %3): done in %4 ms").arg(i).arg(jobs[i].operation, jobs[i].inputFilename).arg(results[i].elapsedMilliseconds);
+        } else {
+            qInfo().noquote() << QString("Job %1 (%2 %3): failed with error %4 %5").arg(i).arg(jobs[i].operation, jobs[i].inputFilename).arg(results[i].result).arg(results[i].errorExtra);
+            failedCount++;
+        }
+    }
+    return (failedCount > 0) ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // SpriteLoader --serve <dat file> [server name] runs headless, serving sprite requests.
+    if ((argc >= 3) && (strcmp(argv[1], "--serve") == 0)) {
+        QCoreApplication a(argc, argv);
+        SpriteServer server;
+        QString serverName = (argc >= 4) ? QString(argv[3]) : QString(DEFAULT_SERVER_NAME);
+        if (!server.start(QString(argv[2]), serverName)) {
+            qCritical() << "Unable to serve" << argv[2];
+            return 1;
+        }
+        return a.exec();
+    }
+
+    // SpriteLoader --batch <job file> runs a JSON list of jobs concurrently.
+    if ((argc >= 3) && (strcmp(argv[1], "--batch") == 0)) {
+        QCoreApplication a(argc, argv);
+        return runBatch(QString(argv[2]));
+    }
+
+    // SpriteLoader --unpack-stream <output directory> unpacks a .dat piped to standard input.
+    if ((argc >= 3) && (strcmp(argv[1], "--unpack-stream") == 0)) {
+        QCoreApplication a(argc, argv);
+        QFile inputFile;
+        if (!inputFile.open(stdin, QIODevice::ReadOnly)) {
+            qCritical() << "Unable to read standard input";
+            return 1;
+        }
+        SpriteEditor spriteEditor;
+        enum SpriteEditorReturn result = spriteEditor.unpackSprites(&inputFile, QString(argv[2]), false);
+        if (result != SER_SUCCESS) {
+            qCritical() << "Unpacking failed with error" << result;
+            return 1;
+        }
+        return 0;
+    }
+
+    // SpriteLoader --verify <input dat> <output dat> checks an output keeps the input's layout.
+    if ((argc >= 4) && (strcmp(argv[1], "--verify") == 0)) {
+        QCoreApplication a(argc, argv);
+        SpriteEditor spriteEditor;
+        QString errorExtra;
+        enum SpriteEditorReturn result = spriteEditor.verifyOutput(QString(argv[2]), QString(argv[3]), &errorExtra);
+        if (result != SER_SUCCESS) {
+            qCritical().noquote() << "Verification failed with error" << result << errorExtra;
+            return 1;
+        }
+        return 0;
+    }
+
+    QApplication a(argc, argv);
+    MainWindow w;
+    w.show();
+    return a.exec();
+}
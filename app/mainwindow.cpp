@@ -0,0 +1,564 @@
+#include "mainwindow.h"
+#include "ui_mainwindow.h"
+#include "spritearchive.h"
+#include "pngfitter.h"
+#include <QDebug>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QFileInfo>
+#include <QPixmap>
+
+#define ATLAS_SIZE 2048
+#define SPRITE_SHARD_SIZE 256
+
+MainWindow::MainWindow(QWidget *parent)
+    : QMainWindow(parent)
+    , ui(new Ui::MainWindow)
+{
+    ui->setupUi(this);
+    inputFilename = QString();
+    outputFilename = QString();
+    inputDirectory = QString();
+    outputDirectory = QString();
+    spriteEditor = SpriteEditor();
+    cachedSize = 0;
+
+    spriteBrowserModel = new SpriteBrowserModel(this);
+    ui->spriteBrowserView->setModel(spriteBrowserModel);
+    connect(ui->spriteBrowserView->selectionModel(), &QItemSelectionModel::currentChanged, this, &MainWindow::showSpriteComparison);
+
+    spriteWatcher = new SpriteWatcher(this);
+    connect(spriteWatcher, &SpriteWatcher::spritesRepacked, this, &MainWindow::onSpritesRepacked);
+}
+
+MainWindow::~MainWindow()
+{
+    delete ui;
+}
+
+
+
+
+void MainWindow::on_inputFileButton_clicked()
+{
+    QString result = QFileDialog::getOpenFileName(this, tr("Select input file"), NULL, tr("Dat Files (*.dat);;All Files (*)"));
+    if (!result.isEmpty()) {
+        inputFilename = result;
+        ui->inputFilenameLabel->setText(inputFilename);
+        ui->watchSpritesCheckBox->setChecked(false);
+        clearInputCache();
+        spriteBrowserModel->setInput(QByteArray(), SpriteIndex());
+        showSpriteComparison(QModelIndex());
+    }
+    ui->statusLabel->setText("");
+
+}
+void MainWindow::on_outputFileButton_clicked()
+{
+    QString result = QFileDialog::getSaveFileName(this, tr("Save File"), NULL, tr("Dat Files (*.dat)"));
+    if (!result.isEmpty()) {
+        if (!result.endsWith(".dat", Qt::CaseInsensitive)) {
+            result += ".dat";
+        }
+        outputFilename = result;
+        ui->outputFilenameLabel->setText(outputFilename);
+        ui->watchSpritesCheckBox->setChecked(false);
+    }
+    ui->statusLabel->setText("");
+}
+
+void MainWindow::on_actionExit_triggered()
+{
+    close();
+}
+
+void MainWindow::on_actionAbout_triggered()
+{
+    QString text = "Includes code from d265f27 - MIT - https://github.com/d265f27\n";
+    text += "Lammert Bies - MIT - https://github.com/lammertb/libcrc\n";
+    text += "QT - LGPL/GPL - https://qt.io";
+    QMessageBox::information(this, tr("Sprite Loader"), text);
+}
+
+
+void MainWindow::on_inputDirectoryButton_clicked()
+{
+    QString result;
+    if (ui->useArchiveCheckBox->isChecked()) {
+        result = QFileDialog::getOpenFileName(this, tr("Select sprite archive"), NULL, tr("Sprite Archives (*.slarc);;All Files (*)"));
+    } else {
+        result = QFileDialog::getExistingDirectory(this, tr("Select sprite load directory"), NULL, QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+    }
+    if (!result.isEmpty()) {
+        inputDirectory = result;
+        ui->inputDirectoryLabel->setText(inputDirectory);
+        ui->watchSpritesCheckBox->setChecked(false);
+        showSpriteComparison(ui->spriteBrowserView->currentIndex());
+    }
+    ui->statusLabel->setText("");
+}
+
+void MainWindow::on_outputDirectoryButton_clicked()
+{
+    QString result;
+    if (ui->useArchiveCheckBox->isChecked()) {
+        result = QFileDialog::getSaveFileName(this, tr("Save sprite archive"), NULL, tr("Sprite Archives (*.slarc)"));
+        if (!result.isEmpty() && !result.endsWith(".slarc", Qt::CaseInsensitive)) {
+            result += ".slarc";
+        }
+    } else {
+        result = QFileDialog::getExistingDirectory(this, tr("Select sprite output directory"), NULL, QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+    }
+    if (!result.isEmpty()) {
+        outputDirectory = result;
+        ui->outputDirectoryLabel->setText(outputDirectory);
+    }
+    ui->statusLabel->setText("");
+}
+
+void MainWindow::on_unpackSpritesButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    if (outputDirectory.isEmpty()) {
+        ui->statusLabel->setText("Error: No output directory set.");
+        return;
+    }
+    SpriteFilter filter;
+    if (!SpriteFilter::parse(ui->unpackFilterEdit->text(), &filter)) {
+        ui->statusLabel->setText("Error: Invalid sprite selection.");
+        return;
+    }
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        if (outputDirectory.endsWith(".slarc", Qt::CaseInsensitive)) {
+            result = spriteEditor.unpackSpritesToArchive(inputFileArray, inputSpriteIndex, outputDirectory, ui->allowOverwritingCheckBox->isChecked(), filter, ui->compressArchiveCheckBox->isChecked());
+        } else {
+            int shardSize = ui->shardDirectoriesCheckBox->isChecked() ? SPRITE_SHARD_SIZE : 0;
+            result = spriteEditor.unpackSprites(inputFileArray, inputSpriteIndex, outputDirectory, ui->allowOverwritingCheckBox->isChecked(), filter, shardSize);
+        }
+    }
+    releaseInput();
+    reportResult(result, "Sucessfully unpacked sprites.", NULL);
+}
+
+void MainWindow::on_packSpritesButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    if (outputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No output filename set.");
+        return;
+    }
+    if (inputDirectory.isEmpty()) {
+        ui->statusLabel->setText("Error: No input directory set.");
+        return;
+    }
+    QString errorExtra;
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        int shardSize = ui->shardDirectoriesCheckBox->isChecked() ? SPRITE_SHARD_SIZE : 0;
+        result = spriteEditor.packSprites(inputFileArray, inputSpriteIndex, outputFilename, inputDirectory, shardSize, &errorExtra);
+    }
+    releaseInput();
+    reportResult(result, "Sucessfully packed sprites.", &errorExtra);
+}
+
+void MainWindow::on_invisibleTrailsButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    if (outputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No output filename set.");
+        return;
+    }
+    QString errorExtra;
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        result = spriteEditor.createInvisibleTrails(inputFileArray, inputSpriteIndex, outputFilename, &errorExtra);
+    }
+    releaseInput();
+    reportResult(result, "Sucessfully created invisible with trails dat.", &errorExtra);
+}
+
+void MainWindow::on_invisibleButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    if (outputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No output filename set.");
+        return;
+    }
+    QString errorExtra;
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        result = spriteEditor.createInvisible(inputFileArray, inputSpriteIndex, outputFilename, &errorExtra);
+    }
+    releaseInput();
+    reportResult(result, "Sucessfully created invisible dat.", &errorExtra);
+}
+
+void MainWindow::on_createPatchButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    if (outputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No output filename set.");
+        return;
+    }
+    QString patchFilename = QFileDialog::getSaveFileName(this, tr("Save patch"), NULL, tr("Sprite Patches (*.slpatch)"));
+    if (patchFilename.isEmpty()) {
+        return;
+    }
+    if (!patchFilename.endsWith(".slpatch", Qt::CaseInsensitive)) {
+        patchFilename += ".slpatch";
+    }
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        result = spriteEditor.createPatch(inputFileArray, inputSpriteIndex, outputFilename, patchFilename, ui->compressPatchCheckBox->isChecked());
+    }
+    releaseInput();
+    reportResult(result, "Sucessfully created patch.", NULL);
+}
+
+void MainWindow::on_applyPatchButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    if (outputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No output filename set.");
+        return;
+    }
+    QString patchFilename = QFileDialog::getOpenFileName(this, tr("Select patch"), NULL, tr("Sprite Patches (*.slpatch);;All Files (*)"));
+    if (patchFilename.isEmpty()) {
+        return;
+    }
+    enum SpriteEditorReturn result = spriteEditor.applyPatch(inputFilename, patchFilename, outputFilename, ui->allowOverwritingCheckBox->isChecked());
+    reportResult(result, "Sucessfully applied patch.", NULL);
+}
+
+void MainWindow::on_exportFingerprintsButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    QString databaseFilename = QFileDialog::getSaveFileName(this, tr("Save fingerprints"), NULL, tr("Sprite Fingerprints (*.slfp)"));
+    if (databaseFilename.isEmpty()) {
+        return;
+    }
+    if (!databaseFilename.endsWith(".slfp", Qt::CaseInsensitive)) {
+        databaseFilename += ".slfp";
+    }
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        result = spriteEditor.exportFingerprints(inputFileArray, inputSpriteIndex, databaseFilename);
+    }
+    releaseInput();
+    reportResult(result, "Sucessfully exported fingerprints.", NULL);
+}
+
+// The input file is the version the sprites were made for, the sprites are copied from the
+// input directory into the output directory with their numbering in the selected new version.
+void MainWindow::on_remapSpritesButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    if (inputDirectory.isEmpty()) {
+        ui->statusLabel->setText("Error: No input directory set.");
+        return;
+    }
+    if (outputDirectory.isEmpty()) {
+        ui->statusLabel->setText("Error: No output directory set.");
+        return;
+    }
+    QString newFilename = QFileDialog::getOpenFileName(this, tr("Select new version"), NULL, tr("Dat Files (*.dat);;Sprite Fingerprints (*.slfp);;All Files (*)"));
+    if (newFilename.isEmpty()) {
+        return;
+    }
+    QString errorExtra;
+    enum SpriteEditorReturn result = spriteEditor.remapSprites(inputFilename, newFilename, inputDirectory, outputDirectory, ui->allowOverwritingCheckBox->isChecked(), &errorExtra);
+    reportResult(result, "Sucessfully remapped sprites.", &errorExtra);
+}
+
+void MainWindow::on_exportAtlasesButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    if (outputDirectory.isEmpty()) {
+        ui->statusLabel->setText("Error: No output directory set.");
+        return;
+    }
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        result = spriteEditor.exportAtlases(inputFileArray, inputSpriteIndex, outputDirectory, ATLAS_SIZE, ui->allowOverwritingCheckBox->isChecked());
+    }
+    releaseInput();
+    reportResult(result, "Sucessfully exported atlases.", NULL);
+}
+void MainWindow::on_exportCatalogButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    QString selectedFilter;
+    QString catalogFilename = QFileDialog::getSaveFileName(this, tr("Save catalog"), NULL, tr("Sprite Catalogs (*.slcat);;JSON Files (*.json)"), &selectedFilter);
+    if (catalogFilename.isEmpty()) {
+        return;
+    }
+    if (!catalogFilename.endsWith(".slcat", Qt::CaseInsensitive) && !catalogFilename.endsWith(".json", Qt::CaseInsensitive)) {
+        if (selectedFilter.contains("json")) {
+            catalogFilename += ".json";
+        } else {
+            catalogFilename += ".slcat";
+        }
+    }
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        result = spriteEditor.exportCatalog(inputSpriteIndex, catalogFilename);
+    }
+    releaseInput();
+    reportResult(result, "Sucessfully exported catalog.", NULL);
+}
+
+void MainWindow::on_keepInputLoadedCheckBox_toggled(bool checked)
+{
+    if (!checked) {
+        clearInputCache();
+    }
+}
+
+void MainWindow::on_directIOCheckBox_toggled(bool checked)
+{
+    spriteEditor.setDirectIO(checked);
+    spriteWatcher->setDirectIO(checked);
+}
+
+// Packs once, then keeps the output up to date by writing only the sprites which change.
+void MainWindow::on_watchSpritesCheckBox_toggled(bool checked)
+{
+    if (!checked) {
+        if (spriteWatcher->isWatching()) {
+            spriteWatcher->stop();
+            ui->statusLabel->setText("Stopped watching the input directory.");
+        }
+        return;
+    }
+    QString error;
+    if (inputFilename.isEmpty()) {
+        error = "Error: No input filename set.";
+    } else if (outputFilename.isEmpty()) {
+        error = "Error: No output filename set.";
+    } else if (inputDirectory.isEmpty()) {
+        error = "Error: No input directory set.";
+    } else if (QFileInfo(inputDirectory).isFile()) {
+        error = "Error: Sprite archives can't be watched.";
+    }
+    if (!error.isEmpty()) {
+        ui->watchSpritesCheckBox->setChecked(false);
+        ui->statusLabel->setText(error);
+        return;
+    }
+
+    QString errorExtra;
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        int shardSize = ui->shardDirectoriesCheckBox->isChecked() ? SPRITE_SHARD_SIZE : 0;
+        result = spriteWatcher->start(inputFileArray, inputSpriteIndex, inputDirectory, shardSize, outputFilename, &errorExtra);
+    }
+    releaseInput();
+    if (result != SER_SUCCESS) {
+        ui->watchSpritesCheckBox->setChecked(false);
+    }
+    reportResult(result, "Packed sprites, watching the input directory for changes.", &errorExtra);
+}
+
+void MainWindow::onSpritesRepacked(int spriteCount, int result, QString errorExtra)
+{
+    QString message = QString("Repacked %1 changed sprites.").arg(spriteCount);
+    reportResult((enum SpriteEditorReturn) result, message.toUtf8().constData(), &errorExtra);
+}
+
+// The browser keeps its own reference to the input, so it stays browsable after release.
+void MainWindow::on_browseSpritesButton_clicked()
+{
+    if (inputFilename.isEmpty()) {
+        ui->statusLabel->setText("Error: No input filename set.");
+        return;
+    }
+    enum SpriteEditorReturn result = loadInput();
+    if (result == SER_SUCCESS) {
+        spriteBrowserModel->setInput(inputFileArray, inputSpriteIndex);
+        showSpriteComparison(QModelIndex());
+    }
+    releaseInput();
+    reportResult(result, "Loaded sprites into the browser.", NULL);
+}
+
+// Shows the selected sprite next to its replacement in the sprite input directory or archive.
+void MainWindow::showSpriteComparison(const QModelIndex &current)
+{
+    if (!current.isValid()) {
+        setComparisonImage(ui->spriteOriginalLabel, QImage(), "Original");
+        setComparisonImage(ui->spriteReplacementLabel, QImage(), "Replacement");
+        ui->spriteDetailsLabel->setText("Select a sprite to compare it with its replacement in the sprite input directory.");
+        return;
+    }
+    uint32_t index = current.row();
+    const SpriteIndex &spriteIndex = spriteBrowserModel->getSpriteIndex();
+    QByteArray originalArray = spriteBrowserModel->getSprite(index);
+    setComparisonImage(ui->spriteOriginalLabel, QImage::fromData(originalArray, "PNG"), "Unable to decode");
+    QString details = QString("Sprite %1: %2x%3, %4 byte slot.").arg(index).arg(spriteIndex.width(index)).arg(spriteIndex.height(index)).arg(spriteIndex.length(index));
+
+    QByteArray replacementArray;
+    bool hasReplacement = false;
+    if (!inputDirectory.isEmpty()) {
+        if (QFileInfo(inputDirectory).isFile()) {
+            SpriteArchive archive;
+            hasReplacement = archive.open(inputDirectory) && archive.contains(index) && archive.read(index, &replacementArray);
+        } else {
+            int shardSize = ui->shardDirectoriesCheckBox->isChecked() ? SPRITE_SHARD_SIZE : 0;
+            QFile replacementFile(spriteEditor.getSpriteFilename(QDir(inputDirectory), index, shardSize));
+            if (replacementFile.open(QIODevice::ReadOnly)) {
+                replacementArray = replacementFile.readAll();
+                replacementFile.close();
+                hasReplacement = true;
+            }
+        }
+    }
+    if (!hasReplacement) {
+        setComparisonImage(ui->spriteReplacementLabel, QImage(), "No replacement");
+        ui->spriteDetailsLabel->setText(details);
+        return;
+    }
+    QImage replacement = QImage::fromData(replacementArray, "PNG");
+    setComparisonImage(ui->spriteReplacementLabel, replacement, "Unable to decode");
+    details += QString(" Replacement: %1x%2, %3 bytes, ").arg(replacement.width()).arg(replacement.height()).arg(replacementArray.size());
+    if (PNGFitter::fitsSlot(replacementArray.size(), spriteIndex.length(index))) {
+        details += "fits its slot.";
+    } else {
+        details += "must be shrunk to fit its slot.";
+    }
+    ui->spriteDetailsLabel->setText(details);
+}
+
+// Large sprites are scaled down to the label, small ones are shown at their own size.
+void MainWindow::setComparisonImage(QLabel *label, const QImage &image, QString emptyText)
+{
+    if (image.isNull()) {
+        label->setText(emptyText);
+        return;
+    }
+    QImage shownImage = image;
+    if ((image.width() > label->width()) || (image.height() > label->height())) {
+        shownImage = image.scaled(label->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    label->setPixmap(QPixmap::fromImage(shownImage));
+}
+
+
+// Loads and indexes the input file, unless the same file is already loaded and has not
+// changed on disk since.
+enum SpriteEditorReturn MainWindow::loadInput()
+{
+    QFileInfo inputInfo(inputFilename);
+    if (!inputFileArray.isEmpty() && (cachedFilename == inputInfo.absoluteFilePath()) &&
+            (cachedSize == inputInfo.size()) && (cachedModified == inputInfo.lastModified())) {
+        return SER_SUCCESS;
+    }
+    clearInputCache();
+    enum SpriteEditorReturn result = spriteEditor.loadInput(inputFilename, &inputFileArray, &inputSpriteIndex);
+    if (result != SER_SUCCESS) {
+        clearInputCache();
+        return result;
+    }
+    cachedFilename = inputInfo.absoluteFilePath();
+    cachedSize = inputInfo.size();
+    cachedModified = inputInfo.lastModified();
+    return SER_SUCCESS;
+}
+
+// Called after every action, drops the input unless it should stay loaded.
+void MainWindow::releaseInput()
+{
+    if (!ui->keepInputLoadedCheckBox->isChecked()) {
+        clearInputCache();
+    }
+}
+
+void MainWindow::clearInputCache()
+{
+    inputFileArray = QByteArray();
+    inputSpriteIndex = SpriteIndex();
+    cachedFilename = QString();
+    cachedSize = 0;
+    cachedModified = QDateTime();
+}
+
+
+void MainWindow::reportResult(enum SpriteEditorReturn result, const char *string, QString *errorExtra)
+{
+    if (result == SER_SUCCESS) {
+        ui->statusLabel->setText(string);
+    } else if (result == SER_ERROR_INPUT_FILE) {
+        ui->statusLabel->setText("Error: Unable to read input file.");
+    } else if (result == SER_ERROR_OUTPUT_DIR) {
+        ui->statusLabel->setText("Error: Unable to open output directory.");
+    } else if (result == SER_ERROR_PNG_OUTPUT) {
+        ui->statusLabel->setText("Error: Failed to save an image.");
+    } else if (result == SER_ERROR_INPUT_DIR) {
+        ui->statusLabel->setText("Error: Unable to open input directory.");
+    } else if (result == SER_ERROR_OVERWRITE) {
+        ui->statusLabel->setText("Error: Would overwrite files.");
+    } else if (result == SER_ERROR_INTERNAL) {
+        ui->statusLabel->setText("Error: Internal error.");
+    } else if (result == SER_ERROR_INPUT_PNG) {
+        ui->statusLabel->setText("Error: Unable to open image: " + *errorExtra);
+    } else if (result == SER_ERROR_PNG_SIZE) {
+        ui->statusLabel->setText("Error: Image too large: " + *errorExtra);
+    } else if (result == SER_ERROR_DAT_OUTPUT) {
+        ui->statusLabel->setText("Error: Unable to write .dat file.");
+    } else if (result == SER_ERROR_INPUT_PATCH) {
+        ui->statusLabel->setText("Error: Unable to read patch file.");
+    } else if (result == SER_ERROR_PATCH_OUTPUT) {
+        ui->statusLabel->setText("Error: Unable to write patch file.");
+    } else if (result == SER_ERROR_PATCH_MISMATCH) {
+        ui->statusLabel->setText("Error: Files do not match the patch layout.");
+    } else if (result == SER_ERROR_INPUT_FINGERPRINTS) {
+        ui->statusLabel->setText("Error: Unable to read fingerprints.");
+    } else if (result == SER_ERROR_FINGERPRINT_OUTPUT) {
+        ui->statusLabel->setText("Error: Unable to write fingerprints.");
+    } else if (result == SER_ERROR_REMAP_UNMATCHED) {
+        ui->statusLabel->setText("Error: No match in new version for: " + *errorExtra);
+    } else if (result == SER_ERROR_CATALOG_OUTPUT) {
+        ui->statusLabel->setText("Error: Unable to write catalog.");
+    } else if (result == SER_ERROR_INPUT_ARCHIVE) {
+        ui->statusLabel->setText("Error: Unable to read sprite archive.");
+    } else if (result == SER_ERROR_UNKNOWN_VERSION) {
+        ui->statusLabel->setText("Error: Unrecognised version of the input file.");
+    } else if (result == SER_ERROR_VERIFY) {
+        if ((errorExtra != NULL) && !errorExtra->isEmpty()) {
+            ui->statusLabel->setText("Error: Output failed verification: " + *errorExtra);
+        } else {
+            ui->statusLabel->setText("Error: Output failed verification.");
+        }
+    }
+
+}
@@ -0,0 +1,92 @@
+#ifndef MAINWINDOW_H
+#define MAINWINDOW_H
+
+#include "spriteeditor.h"
+#include "spritebrowsermodel.h"
+#include "spritewatcher.h"
+#include <QMainWindow>
+#include <QDateTime>
+#include <QLabel>
+
+QT_BEGIN_NAMESPACE
+namespace Ui { class MainWindow; }
+QT_END_NAMESPACE
+
+class MainWindow : public QMainWindow
+{
+    Q_OBJECT
+
+public:
+    MainWindow(QWidget *parent = nullptr);
+    ~MainWindow();
+
+private slots:
+    void on_inputFileButton_clicked();
+
+    void on_actionExit_triggered();
+
+    void on_actionAbout_triggered();
+
+    void on_outputFileButton_clicked();
+
+    void on_inputDirectoryButton_clicked();
+
+    void on_outputDirectoryButton_clicked();
+
+    void on_unpackSpritesButton_clicked();
+
+    void on_packSpritesButton_clicked();
+
+    void on_invisibleTrailsButton_clicked();
+
+    void on_invisibleButton_clicked();
+
+    void on_createPatchButton_clicked();
+
+    void on_applyPatchButton_clicked();
+
+    void on_exportFingerprintsButton_clicked();
+
+    void on_remapSpritesButton_clicked();
+
+    void on_exportAtlasesButton_clicked();
+
+    void on_exportCatalogButton_clicked();
+
+    void on_keepInputLoadedCheckBox_toggled(bool checked);
+
+    void on_directIOCheckBox_toggled(bool checked);
+
+    void on_browseSpritesButton_clicked();
+
+    void showSpriteComparison(const QModelIndex &current);
+
+    void on_watchSpritesCheckBox_toggled(bool checked);
+
+    void onSpritesRepacked(int spriteCount, int result, QString errorExtra);
+
+private:
+    Ui::MainWindow *ui;
+    SpriteEditor spriteEditor;
+    void reportResult(enum SpriteEditorReturn result, const char *string, QString *errorExtra);
+    enum SpriteEditorReturn loadInput();
+    void releaseInput();
+    void clearInputCache();
+    void setComparisonImage(QLabel *label, const QImage &image, QString emptyText);
+
+    QString inputFilename;
+    QString outputFilename;
+    QString inputDirectory;
+    QString outputDirectory;
+
+    // The loaded input file and its index, kept between actions while the file is unchanged.
+    QByteArray inputFileArray;
+    SpriteIndex inputSpriteIndex;
+    QString cachedFilename;
+    qint64 cachedSize;
+    QDateTime cachedModified;
+
+    SpriteBrowserModel *spriteBrowserModel;
+    SpriteWatcher *spriteWatcher;
+};
+#endif // MAINWINDOW_H
@@ -0,0 +1,132 @@
+#include "spritebrowsermodel.h"
+
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstdlib>
+
+#define THUMBNAIL_SIZE 64
+#define THUMBNAIL_CACHE_COST (32 << 20)
+// Decodes queued for rows this far from where the view last painted are skipped, so
+// scrolling quickly through all sprites does not leave a backlog of invisible ones.
+#define DECODE_SKIP_DISTANCE 256
+
+SpriteBrowserModel::SpriteBrowserModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    generation = 0;
+    thumbnails.setMaxCost(THUMBNAIL_CACHE_COST);
+    connect(this, &SpriteBrowserModel::thumbnailDecoded, this, &SpriteBrowserModel::onThumbnailDecoded, Qt::QueuedConnection);
+}
+
+SpriteBrowserModel::~SpriteBrowserModel()
+{
+    decodePool.clear();
+    decodePool.waitForDone();
+}
+
+
+void SpriteBrowserModel::setInput(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex)
+{
+    beginResetModel();
+    this->inputFileArray = inputFileArray;
+    this->spriteIndex = spriteIndex;
+    generation++;
+    thumbnails.clear();
+    pendingRows.clear();
+    lastRequestedRow.storeRelease(0);
+    endResetModel();
+}
+
+
+// Returns a view of the sprite, valid until the input is replaced.
+QByteArray SpriteBrowserModel::getSprite(int row) const
+{
+    if ((row < 0) || (row >= (int) spriteIndex.size())) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(inputFileArray.constData() + spriteIndex.offset(row), spriteIndex.length(row));
+}
+
+
+const SpriteIndex &SpriteBrowserModel::getSpriteIndex() const
+{
+    return spriteIndex;
+}
+
+
+int SpriteBrowserModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return spriteIndex.size();
+}
+
+
+QVariant SpriteBrowserModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (index.row() >= (int) spriteIndex.size())) {
+        return QVariant();
+    }
+    int row = index.row();
+    if (role == Qt::DisplayRole) {
+        return QString::number(row);
+    }
+    if (role == Qt::ToolTipRole) {
+        return QString("Sprite %1: %2x%3, %4 bytes").arg(row).arg(spriteIndex.width(row)).arg(spriteIndex.height(row)).arg(spriteIndex.length(row));
+    }
+    if (role == Qt::DecorationRole) {
+        lastRequestedRow.storeRelease(row);
+        QImage *thumbnail = thumbnails.object(row);
+        if (thumbnail) {
+            return *thumbnail;
+        }
+        requestThumbnail(row);
+    }
+    return QVariant();
+}
+
+
+void SpriteBrowserModel::requestThumbnail(int row) const
+{
+    if (pendingRows.contains(row)) {
+        return;
+    }
+    pendingRows.insert(row);
+
+    // The decode holds its own reference to the input, which may be replaced meanwhile.
+    SpriteBrowserModel *model = const_cast<SpriteBrowserModel *>(this);
+    QByteArray array = inputFileArray;
+    int offset = spriteIndex.offset(row);
+    int length = spriteIndex.length(row);
+    int decodeGeneration = generation;
+    QtConcurrent::run(&model->decodePool, [model, array, offset, length, row, decodeGeneration]() {
+        if (abs(row - model->lastRequestedRow.loadAcquire()) > DECODE_SKIP_DISTANCE) {
+            emit model->thumbnailDecoded(row, QImage(), false, decodeGeneration);
+            return;
+        }
+        QImage image = QImage::fromData((const uchar *) array.constData() + offset, length, "PNG");
+        if ((image.width() > THUMBNAIL_SIZE) || (image.height() > THUMBNAIL_SIZE)) {
+            image = image.scaled(THUMBNAIL_SIZE, THUMBNAIL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        emit model->thumbnailDecoded(row, image, true, decodeGeneration);
+    });
+}
+
+
+// Runs on the GUI thread. Sprites which fail to decode are cached as empty images so they
+// are not decoded again on every repaint.
+void SpriteBrowserModel::onThumbnailDecoded(int row, QImage thumbnail, bool isDecoded, int decodeGeneration)
+{
+    if (decodeGeneration != generation) {
+        return;
+    }
+    pendingRows.remove(row);
+    if (!isDecoded) {
+        return;
+    }
+    int cost = std::max(1, thumbnail.width() * thumbnail.height() * 4);
+    thumbnails.insert(row, new QImage(thumbnail), cost);
+    QModelIndex changedIndex = index(row);
+    emit dataChanged(changedIndex, changedIndex, {Qt::DecorationRole});
+}
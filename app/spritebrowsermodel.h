@@ -0,0 +1,48 @@
+#ifndef SPRITEBROWSERMODEL_H
+#define SPRITEBROWSERMODEL_H
+
+#include "spriteindex.h"
+
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QSet>
+#include <QThreadPool>
+
+// One row per sprite of the input. Thumbnails are decoded on a thread pool only when the
+// view asks for them, which it does for visible cells only, and kept in a bounded LRU cache.
+class SpriteBrowserModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    SpriteBrowserModel(QObject *parent = nullptr);
+    ~SpriteBrowserModel();
+
+    void setInput(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex);
+    QByteArray getSprite(int row) const;
+    const SpriteIndex &getSpriteIndex() const;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+signals:
+    void thumbnailDecoded(int row, QImage thumbnail, bool isDecoded, int decodeGeneration);
+
+private slots:
+    void onThumbnailDecoded(int row, QImage thumbnail, bool isDecoded, int decodeGeneration);
+
+private:
+    void requestThumbnail(int row) const;
+
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    // Bumped by setInput so decodes of a previous input are dropped.
+    int generation;
+    mutable QCache<int, QImage> thumbnails;
+    mutable QSet<int> pendingRows;
+    mutable QAtomicInt lastRequestedRow;
+    QThreadPool decodePool;
+};
+
+#endif // SPRITEBROWSERMODEL_H
@@ -0,0 +1,178 @@
+#include "spriteserver.h"
+
+#include <QDebug>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#define REQUEST_HEADER_LENGTH 9
+#define RESPONSE_HEADER_LENGTH 5
+
+SpriteServer::SpriteServer(QObject *parent)
+    : QObject(parent)
+{
+    datMap = NULL;
+    maximumPayloadLength = 0;
+    connect(&server, &QLocalServer::newConnection, this, &SpriteServer::onNewConnection);
+}
+
+
+SpriteServer::~SpriteServer()
+{
+    server.close();
+    if (datMap != NULL) {
+        datFile.unmap(datMap);
+    }
+    datFile.close();
+}
+
+
+bool SpriteServer::start(QString datFilename, QString serverName)
+{
+    // Unbuffered so that each replacement is a single write at the slot offset.
+    datFile.setFileName(datFilename);
+    if (!datFile.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        return false;
+    }
+    if (datFile.size() != GAMEDATA_DAT_LENGTH) {
+        datFile.close();
+        return false;
+    }
+    datMap = datFile.map(0, datFile.size());
+    if (datMap == NULL) {
+        datFile.close();
+        return false;
+    }
+    // The mapping is shared with the file, so it sees our own writes without rescanning.
+    datArray = QByteArray::fromRawData((const char *) datMap, datFile.size());
+    spriteIndex = SpriteIndex::build(datArray);
+    if (spriteIndex.isEmpty()) {
+        return false;
+    }
+    maximumPayloadLength = 0;
+    for (uint32_t i = 0; i < spriteIndex.size(); i++) {
+        maximumPayloadLength = std::max(maximumPayloadLength, spriteIndex.length(i));
+    }
+
+    QLocalServer::removeServer(serverName);
+    return server.listen(serverName);
+}
+
+
+void SpriteServer::onNewConnection()
+{
+    while (server.hasPendingConnections()) {
+        QLocalSocket *socket = server.nextPendingConnection();
+        socketBuffers.insert(socket, QByteArray());
+        connect(socket, &QLocalSocket::readyRead, this, &SpriteServer::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, &SpriteServer::onDisconnected);
+    }
+}
+
+
+void SpriteServer::onReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+    if ((socket == NULL) || (socket->state() != QLocalSocket::ConnectedState)) {
+        return;
+    }
+    QByteArray &buffer = socketBuffers[socket];
+    buffer += socket->readAll();
+
+    // Handle every complete request in the buffer.
+    while (buffer.size() >= REQUEST_HEADER_LENGTH) {
+        const uchar *header = (const uchar *) buffer.constData();
+        quint8 opcode = header[0];
+        quint32 index = qFromBigEndian<quint32>(header + 1);
+        quint32 payloadLength = qFromBigEndian<quint32>(header + 5);
+        // No valid request carries more than the largest slot, a client claiming otherwise
+        // would have everything it sends buffered.
+        if (payloadLength > (quint32) maximumPayloadLength) {
+            sendResponse(socket, SER_ERROR_PNG_SIZE, NULL, 0);
+            socketBuffers.remove(socket);
+            socket->disconnectFromServer();
+            return;
+        }
+        if ((quint32) buffer.size() - REQUEST_HEADER_LENGTH < payloadLength) {
+            break;
+        }
+        QByteArray payload = buffer.mid(REQUEST_HEADER_LENGTH, payloadLength);
+        buffer.remove(0, REQUEST_HEADER_LENGTH + payloadLength);
+        handleRequest(socket, opcode, index, payload);
+    }
+}
+
+
+void SpriteServer::onDisconnected()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket == NULL) {
+        return;
+    }
+    socketBuffers.remove(socket);
+    socket->deleteLater();
+}
+
+
+void SpriteServer::handleRequest(QLocalSocket *socket, quint8 opcode, quint32 index, const QByteArray &payload)
+{
+    if (opcode == OP_COUNT) {
+        uchar count[sizeof(quint32)];
+        qToBigEndian<quint32>(spriteIndex.size(), count);
+        sendResponse(socket, SER_SUCCESS, (const char *) count, sizeof(quint32));
+        return;
+    }
+    if (opcode == OP_FLUSH) {
+        bool isFlushed = datFile.flush();
+#ifdef Q_OS_UNIX
+        isFlushed = isFlushed && (fsync(datFile.handle()) == 0);
+#endif
+        sendResponse(socket, isFlushed ? SER_SUCCESS : SER_ERROR_DAT_OUTPUT, NULL, 0);
+        return;
+    }
+    if ((opcode != OP_EXTRACT) && (opcode != OP_REPLACE)) {
+        sendResponse(socket, SER_ERROR_INTERNAL, NULL, 0);
+        return;
+    }
+    if (index >= spriteIndex.size()) {
+        sendResponse(socket, SER_ERROR_INPUT_PNG, NULL, 0);
+        return;
+    }
+
+    if (opcode == OP_EXTRACT) {
+        sendResponse(socket, SER_SUCCESS, datArray.constData() + spriteIndex.offset(index), spriteIndex.length(index));
+        return;
+    }
+
+    enum SpriteEditorReturn result;
+    char *paddedPNG = spriteEditor.getReplacementPNG(payload, spriteIndex.length(index), &result);
+    if (paddedPNG == NULL) {
+        sendResponse(socket, result, NULL, 0);
+        return;
+    }
+    if (!SpriteEditor::isValidSlot(paddedPNG, spriteIndex.length(index))) {
+        free(paddedPNG);
+        sendResponse(socket, SER_ERROR_VERIFY, NULL, 0);
+        return;
+    }
+    if (!datFile.seek(spriteIndex.offset(index)) || (datFile.write(paddedPNG, spriteIndex.length(index)) < spriteIndex.length(index))) {
+        result = SER_ERROR_DAT_OUTPUT;
+    }
+    free(paddedPNG);
+    sendResponse(socket, result, NULL, 0);
+}
+
+
+void SpriteServer::sendResponse(QLocalSocket *socket, enum SpriteEditorReturn status, const char *payload, int length)
+{
+    uchar header[RESPONSE_HEADER_LENGTH];
+    header[0] = (uchar) status;
+    qToBigEndian<quint32>(length, header + 1);
+    socket->write((const char *) header, RESPONSE_HEADER_LENGTH);
+    if (length > 0) {
+        socket->write(payload, length);
+    }
+}
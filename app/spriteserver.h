@@ -0,0 +1,50 @@
+#ifndef SPRITESERVER_H
+#define SPRITESERVER_H
+
+#include "spriteeditor.h"
+#include "spriteindex.h"
+
+#include <QFile>
+#include <QHash>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+
+// Keeps a .dat mapped with its index built and serves sprite requests over a local socket.
+// Replacements are written to the .dat in place.
+//
+// Requests are an opcode byte, a 32 bit sprite index and a 32 bit payload length followed by
+// the payload. Responses are a status byte (a SpriteEditorReturn), a 32 bit payload length
+// and the payload. All integers are big endian. A client sending a payload longer than the
+// largest slot is disconnected.
+class SpriteServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Opcode {OP_COUNT = 0, OP_EXTRACT = 1, OP_REPLACE = 2, OP_FLUSH = 3};
+
+    SpriteServer(QObject *parent = nullptr);
+    ~SpriteServer();
+    bool start(QString datFilename, QString serverName);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    void handleRequest(QLocalSocket *socket, quint8 opcode, quint32 index, const QByteArray &payload);
+    void sendResponse(QLocalSocket *socket, enum SpriteEditorReturn status, const char *payload, int length);
+
+    SpriteEditor spriteEditor;
+    QLocalServer server;
+    QFile datFile;
+    uchar *datMap;
+    QByteArray datArray;
+    SpriteIndex spriteIndex;
+    int maximumPayloadLength;
+    QHash<QLocalSocket*, QByteArray> socketBuffers;
+};
+
+#endif // SPRITESERVER_H
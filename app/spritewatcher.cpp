@@ -0,0 +1,270 @@
+#include "spritewatcher.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+
+#define WATCH_DEBOUNCE_MS 150
+
+SpriteWatcher::SpriteWatcher(QObject *parent)
+    : QObject(parent)
+{
+    isActive = false;
+    shardSize = 0;
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(WATCH_DEBOUNCE_MS);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &SpriteWatcher::onPathChanged);
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &SpriteWatcher::onPathChanged);
+    connect(&debounceTimer, &QTimer::timeout, this, &SpriteWatcher::onDebounceTimeout);
+}
+
+
+// The directory is scanned and watched before the full pack, so saves made during the pack
+// are picked up afterwards rather than lost.
+enum SpriteEditorReturn SpriteWatcher::start(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString inputDirectory, int shardSize, QString outputFilename, QString *errorExtra)
+{
+    stop();
+    QFileInfo directoryInfo(inputDirectory);
+    if (!directoryInfo.isDir()) {
+        return SER_ERROR_INPUT_DIR;
+    }
+    this->inputFileArray = inputFileArray;
+    this->spriteIndex = spriteIndex;
+    rootDirectory = directoryInfo.absoluteFilePath();
+    this->shardSize = shardSize;
+    this->outputFilename = outputFilename;
+
+    watcher.addPath(rootDirectory);
+    QSet<uint32_t> changed;
+    scanRoot(&changed);
+
+    enum SpriteEditorReturn result = spriteEditor.packSprites(inputFileArray, spriteIndex, outputFilename, rootDirectory, shardSize, errorExtra);
+    if (result != SER_SUCCESS) {
+        stop();
+        return result;
+    }
+    isActive = true;
+    return SER_SUCCESS;
+}
+
+
+void SpriteWatcher::stop()
+{
+    debounceTimer.stop();
+    if (!watcher.files().isEmpty()) {
+        watcher.removePaths(watcher.files());
+    }
+    if (!watcher.directories().isEmpty()) {
+        watcher.removePaths(watcher.directories());
+    }
+    knownFiles.clear();
+    spriteFiles.clear();
+    dirtyPaths.clear();
+    inputFileArray = QByteArray();
+    spriteIndex = SpriteIndex();
+    isActive = false;
+}
+
+
+bool SpriteWatcher::isWatching() const
+{
+    return isActive;
+}
+
+
+// Only affects the full pack when watching starts, changes are always written in place.
+void SpriteWatcher::setDirectIO(bool directIO)
+{
+    spriteEditor.setDirectIO(directIO);
+}
+
+
+void SpriteWatcher::onPathChanged(const QString &path)
+{
+    dirtyPaths.insert(path);
+    debounceTimer.start();
+}
+
+
+// Works out which sprites changed since the last time and writes only those.
+void SpriteWatcher::onDebounceTimeout()
+{
+    if (!isActive) {
+        return;
+    }
+    QSet<QString> paths = dirtyPaths;
+    dirtyPaths.clear();
+
+    QSet<uint32_t> changed;
+    for (const QString &path : paths) {
+        if (path == rootDirectory) {
+            scanRoot(&changed);
+        } else if (watcher.directories().contains(path)) {
+            uint32_t shard = QFileInfo(path).fileName().toUInt();
+            scanDirectory(path, shard * shardSize, (shard + 1) * shardSize, &changed);
+        } else {
+            checkFile(path, &changed);
+        }
+    }
+    if (changed.isEmpty()) {
+        return;
+    }
+
+    QMap<uint32_t, QByteArray> replacements;
+    QString errorExtra;
+    enum SpriteEditorReturn result = SER_SUCCESS;
+    for (uint32_t index : changed) {
+        QByteArray pngArray;
+        if (spriteFiles.contains(index)) {
+            QFile inputPNG(spriteFiles.value(index));
+            if (!inputPNG.open(QIODevice::ReadOnly)) {
+                // Most likely still being saved, the save finishing triggers another pass.
+                if (result == SER_SUCCESS) {
+                    result = SER_ERROR_INPUT_PNG;
+                    errorExtra = QFileInfo(spriteFiles.value(index)).fileName();
+                }
+                continue;
+            }
+            pngArray = inputPNG.readAll();
+            inputPNG.close();
+        }
+        replacements.insert(index, pngArray);
+    }
+
+    uint32_t errorIndex = 0;
+    enum SpriteEditorReturn replaceResult = spriteEditor.replaceSpritesInFile(inputFileArray, spriteIndex, outputFilename, replacements, &errorIndex);
+    if ((replaceResult != SER_SUCCESS) && (result == SER_SUCCESS)) {
+        result = replaceResult;
+        errorExtra = "image" + QString::number(errorIndex) + ".png";
+    }
+    emit spritesRepacked(replacements.size(), result, errorExtra);
+}
+
+
+void SpriteWatcher::scanRoot(QSet<uint32_t> *changed)
+{
+    if (shardSize <= 0) {
+        scanDirectory(rootDirectory, 0, spriteIndex.size(), changed);
+        return;
+    }
+
+    // Shards are only scanned as a whole when the root changes, which is when one is added
+    // or removed.
+    QDir directory(rootDirectory);
+    uint32_t shardCount = (spriteIndex.size() + shardSize - 1) / shardSize;
+    QSet<QString> shardPaths;
+    QStringList shardList = directory.entryList(QStringList(), QDir::Dirs | QDir::NoDotAndDotDot, QDir::NoSort);
+    for (const QString &shardName : shardList) {
+        bool validNumber;
+        uint32_t shard = shardName.toUInt(&validNumber);
+        if (!validNumber || (shard >= shardCount)) {
+            continue;
+        }
+        QString shardPath = directory.absoluteFilePath(shardName);
+        shardPaths.insert(shardPath);
+        if (!watcher.directories().contains(shardPath)) {
+            watcher.addPath(shardPath);
+        }
+        scanDirectory(shardPath, shard * shardSize, (shard + 1) * shardSize, changed);
+    }
+
+    // Sprites in shards which no longer exist are restored.
+    QStringList knownPaths = knownFiles.keys();
+    for (const QString &path : knownPaths) {
+        if (!shardPaths.contains(knownFiles.value(path).directory)) {
+            forgetFile(path, changed);
+        }
+    }
+    QStringList watchedDirectories = watcher.directories();
+    for (const QString &path : watchedDirectories) {
+        if ((path != rootDirectory) && !shardPaths.contains(path)) {
+            watcher.removePath(path);
+        }
+    }
+}
+
+
+// Picks up added, changed and removed imageN.png files in one directory. Only sprites from
+// firstIndex up to endIndex belong in it, the same as when packing.
+void SpriteWatcher::scanDirectory(const QString &path, uint32_t firstIndex, uint32_t endIndex, QSet<uint32_t> *changed)
+{
+    QDir directory(path);
+    QSet<QString> presentPaths;
+    QStringList fileList = directory.entryList(QStringList(), QDir::Files, QDir::NoSort);
+    for (const QString &filename : fileList) {
+        if (!filename.startsWith("image") || !filename.endsWith(".png")) {
+            continue;
+        }
+        QString numberString = filename;
+        numberString.remove("image");
+        numberString.remove(".png");
+        bool validNumber;
+        uint32_t index = numberString.toUInt(&validNumber);
+        if (!validNumber || (index < firstIndex) || (index >= endIndex) || (index >= spriteIndex.size())) {
+            continue;
+        }
+        QString filePath = directory.absoluteFilePath(filename);
+        presentPaths.insert(filePath);
+        checkFile(filePath, changed);
+    }
+
+    QStringList knownPaths = knownFiles.keys();
+    for (const QString &knownPath : knownPaths) {
+        if ((knownFiles.value(knownPath).directory == path) && !presentPaths.contains(knownPath)) {
+            forgetFile(knownPath, changed);
+        }
+    }
+}
+
+
+// Editors often save by replacing the file, which drops its watch, so it is added again.
+void SpriteWatcher::checkFile(const QString &path, QSet<uint32_t> *changed)
+{
+    QFileInfo fileInfo(path);
+    if (!fileInfo.exists()) {
+        forgetFile(path, changed);
+        return;
+    }
+    QHash<QString, WatchedFile>::iterator known = knownFiles.find(path);
+    if (known != knownFiles.end()) {
+        if ((known->size != fileInfo.size()) || (known->modified != fileInfo.lastModified())) {
+            known->size = fileInfo.size();
+            known->modified = fileInfo.lastModified();
+            changed->insert(known->index);
+            if (!watcher.files().contains(path)) {
+                watcher.addPath(path);
+            }
+        }
+        return;
+    }
+
+    // A file seen for the first time, only reached through a directory scan.
+    QString numberString = fileInfo.fileName();
+    numberString.remove("image");
+    numberString.remove(".png");
+    WatchedFile watchedFile;
+    watchedFile.index = numberString.toUInt();
+    watchedFile.directory = fileInfo.absolutePath();
+    watchedFile.size = fileInfo.size();
+    watchedFile.modified = fileInfo.lastModified();
+    knownFiles.insert(path, watchedFile);
+    spriteFiles.insert(watchedFile.index, path);
+    watcher.addPath(path);
+    changed->insert(watchedFile.index);
+}
+
+
+void SpriteWatcher::forgetFile(const QString &path, QSet<uint32_t> *changed)
+{
+    QHash<QString, WatchedFile>::iterator known = knownFiles.find(path);
+    if (known == knownFiles.end()) {
+        return;
+    }
+    uint32_t index = known->index;
+    if (spriteFiles.value(index) == path) {
+        spriteFiles.remove(index);
+    }
+    knownFiles.erase(known);
+    changed->insert(index);
+}
@@ -0,0 +1,66 @@
+#ifndef SPRITEWATCHER_H
+#define SPRITEWATCHER_H
+
+#include "spriteeditor.h"
+#include "spriteindex.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+// Watches a sprite input directory and writes the sprites which change into the output .dat
+// in place. The output is fully packed once when watching starts. Bursts of saves are
+// collected until the directory has been quiet for a moment, and a deleted sprite restores
+// the original.
+class SpriteWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    SpriteWatcher(QObject *parent = nullptr);
+    enum SpriteEditorReturn start(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString inputDirectory, int shardSize, QString outputFilename, QString *errorExtra);
+    void stop();
+    bool isWatching() const;
+    void setDirectIO(bool directIO);
+
+signals:
+    void spritesRepacked(int spriteCount, int result, QString errorExtra);
+
+private slots:
+    void onPathChanged(const QString &path);
+    void onDebounceTimeout();
+
+private:
+    struct WatchedFile {
+        uint32_t index;
+        QString directory;
+        qint64 size;
+        QDateTime modified;
+    };
+
+    void scanRoot(QSet<uint32_t> *changed);
+    void scanDirectory(const QString &path, uint32_t firstIndex, uint32_t endIndex, QSet<uint32_t> *changed);
+    void checkFile(const QString &path, QSet<uint32_t> *changed);
+    void forgetFile(const QString &path, QSet<uint32_t> *changed);
+
+    SpriteEditor spriteEditor;
+    QFileSystemWatcher watcher;
+    QTimer debounceTimer;
+    bool isActive;
+
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    QString rootDirectory;
+    int shardSize;
+    QString outputFilename;
+
+    QHash<QString, WatchedFile> knownFiles;
+    QHash<uint32_t, QString> spriteFiles;
+    QSet<QString> dirtyPaths;
+};
+
+#endif // SPRITEWATCHER_H
@@ -0,0 +1,112 @@
+#include "atlaspacker.h"
+
+#include <climits>
+
+AtlasPacker::AtlasPacker(int width, int height)
+{
+    atlasWidth = width;
+    atlasHeight = height;
+    maxX = 0;
+    maxY = 0;
+    skyline.push_back({0, 0, width});
+}
+
+
+// Places the rectangle at the lowest position on the skyline, preferring the narrowest
+// segment on ties. Returns false if it does not fit anywhere.
+bool AtlasPacker::insert(int width, int height, int *outputX, int *outputY)
+{
+    int bestIndex = -1;
+    int bestY = INT_MAX;
+    int bestWidth = INT_MAX;
+    for (int i = 0; i < (int) skyline.size(); i++) {
+        int y;
+        if (fits(i, width, height, &y)) {
+            if ((y < bestY) || ((y == bestY) && (skyline[i].width < bestWidth))) {
+                bestIndex = i;
+                bestY = y;
+                bestWidth = skyline[i].width;
+            }
+        }
+    }
+    if (bestIndex == -1) {
+        return false;
+    }
+    *outputX = skyline[bestIndex].x;
+    *outputY = bestY;
+    addNode(bestIndex, *outputX, bestY, width, height);
+    if (*outputX + width > maxX) {
+        maxX = *outputX + width;
+    }
+    if (bestY + height > maxY) {
+        maxY = bestY + height;
+    }
+    return true;
+}
+
+
+int AtlasPacker::usedWidth() const
+{
+    return maxX;
+}
+
+
+int AtlasPacker::usedHeight() const
+{
+    return maxY;
+}
+
+
+bool AtlasPacker::fits(int nodeIndex, int width, int height, int *outputY) const
+{
+    int x = skyline[nodeIndex].x;
+    if (x + width > atlasWidth) {
+        return false;
+    }
+    int widthLeft = width;
+    int i = nodeIndex;
+    int y = skyline[nodeIndex].y;
+    while (widthLeft > 0) {
+        if (skyline[i].y > y) {
+            y = skyline[i].y;
+        }
+        if (y + height > atlasHeight) {
+            return false;
+        }
+        widthLeft -= skyline[i].width;
+        i++;
+    }
+    *outputY = y;
+    return true;
+}
+
+
+void AtlasPacker::addNode(int nodeIndex, int x, int y, int width, int height)
+{
+    skyline.insert(skyline.begin() + nodeIndex, {x, y + height, width});
+
+    // Shrink or remove the segments now covered by the new one.
+    for (int i = nodeIndex + 1; i < (int) skyline.size(); i++) {
+        int previousEnd = skyline[i - 1].x + skyline[i - 1].width;
+        if (skyline[i].x >= previousEnd) {
+            break;
+        }
+        int shrink = previousEnd - skyline[i].x;
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if (skyline[i].width > 0) {
+            break;
+        }
+        skyline.erase(skyline.begin() + i);
+        i--;
+    }
+
+    // Merge neighbouring segments at the same height.
+    for (int i = 0; i < (int) skyline.size() - 1; i++) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+            i--;
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef ATLASPACKER_H
+#define ATLASPACKER_H
+
+#include <vector>
+
+// Skyline bottom-left rectangle packer for a single fixed size atlas.
+class AtlasPacker
+{
+public:
+    AtlasPacker(int width, int height);
+    bool insert(int width, int height, int *outputX, int *outputY);
+    int usedWidth() const;
+    int usedHeight() const;
+
+private:
+    struct SkylineNode {
+        int x;
+        int y;
+        int width;
+    };
+    bool fits(int nodeIndex, int width, int height, int *outputY) const;
+    void addNode(int nodeIndex, int x, int y, int width, int height);
+
+    std::vector<SkylineNode> skyline;
+    int atlasWidth;
+    int atlasHeight;
+    int maxX;
+    int maxY;
+};
+
+#endif // ATLASPACKER_H
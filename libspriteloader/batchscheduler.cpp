@@ -0,0 +1,160 @@
+#include "batchscheduler.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtConcurrent>
+#include <algorithm>
+
+#define BATCH_ATLAS_SIZE 2048
+
+BatchScheduler::BatchScheduler(int maximumConcurrentLoads, int maximumConcurrentJobs)
+    : loadSemaphore(maximumConcurrentLoads), jobSemaphore(maximumConcurrentJobs)
+{
+
+}
+
+
+// The job list is a JSON array of objects with "input", "operation", "source" and "output",
+// and optionally "directIO" and "compress".
+bool BatchScheduler::parseJobs(const QByteArray &json, std::vector<BatchJob> *jobs)
+{
+    QJsonDocument document = QJsonDocument::fromJson(json);
+    if (!document.isArray()) {
+        return false;
+    }
+    QJsonArray jobArray = document.array();
+    for (int i = 0; i < jobArray.size(); i++) {
+        if (!jobArray[i].isObject()) {
+            return false;
+        }
+        QJsonObject jobObject = jobArray[i].toObject();
+        BatchJob job;
+        job.inputFilename = jobObject["input"].toString();
+        job.operation = jobObject["operation"].toString();
+        job.source = jobObject["source"].toString();
+        job.output = jobObject["output"].toString();
+        job.directIO = jobObject["directIO"].toBool(false);
+        job.compress = jobObject["compress"].toBool(false);
+        if (job.inputFilename.isEmpty() || job.operation.isEmpty() || job.output.isEmpty()) {
+            return false;
+        }
+        jobs->push_back(job);
+    }
+    return true;
+}
+
+
+std::vector<BatchResult> BatchScheduler::run(const std::vector<BatchJob> &jobs)
+{
+    // Group the jobs by input so each input is only loaded and scanned once.
+    QHash<QString, std::shared_ptr<LoadedInput>> inputs;
+    std::vector<LoadedInput*> jobInputs;
+    for (uint32_t i = 0; i < jobs.size(); i++) {
+        QString key = QFileInfo(jobs[i].inputFilename).absoluteFilePath();
+        std::shared_ptr<LoadedInput> &input = inputs[key];
+        if (!input) {
+            input = std::make_shared<LoadedInput>();
+            input->isLoaded = false;
+            input->remainingJobs = 0;
+            input->result = SER_SUCCESS;
+        }
+        input->remainingJobs++;
+        jobInputs.push_back(input.get());
+    }
+
+    // Jobs on the same input are started together, so each input is released as early as
+    // possible. A job is only started once a slot is free, each one holds a full size output
+    // while it runs.
+    QHash<LoadedInput*, uint32_t> firstJobs;
+    std::vector<uint32_t> order(jobs.size());
+    for (uint32_t i = 0; i < jobs.size(); i++) {
+        firstJobs.insert(jobInputs[i], std::min(firstJobs.value(jobInputs[i], i), i));
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return firstJobs.value(jobInputs[a]) < firstJobs.value(jobInputs[b]);
+    });
+
+    std::vector<BatchResult> results(jobs.size());
+    std::vector<QFuture<void>> futures;
+    for (uint32_t i : order) {
+        jobSemaphore.acquire();
+        futures.push_back(QtConcurrent::run(QThreadPool::globalInstance(), [this, &jobs, &jobInputs, &results, i]() {
+            results[i] = runJob(jobs[i], jobInputs[i]);
+            jobSemaphore.release();
+        }));
+    }
+    for (uint32_t i = 0; i < futures.size(); i++) {
+        futures[i].waitForFinished();
+    }
+    return results;
+}
+
+
+BatchResult BatchScheduler::runJob(const BatchJob &job, LoadedInput *input)
+{
+    QElapsedTimer timer;
+    timer.start();
+    BatchResult result;
+
+    // The first job on an input loads it while the others on it wait.
+    input->mutex.lock();
+    if (!input->isLoaded) {
+        loadSemaphore.acquire();
+        input->result = spriteEditor.loadInput(job.inputFilename, &input->inputFileArray, &input->spriteIndex);
+        loadSemaphore.release();
+        input->isLoaded = true;
+    }
+    input->mutex.unlock();
+
+    if (input->result != SER_SUCCESS) {
+        result.result = input->result;
+    } else {
+        result.result = runOperation(job, input, &result.errorExtra);
+    }
+
+    input->mutex.lock();
+    input->remainingJobs--;
+    if (input->remainingJobs == 0) {
+        input->inputFileArray = QByteArray();
+        input->spriteIndex = SpriteIndex();
+    }
+    input->mutex.unlock();
+
+    result.elapsedMilliseconds = timer.elapsed();
+    return result;
+}
+
+
+enum SpriteEditorReturn BatchScheduler::runOperation(const BatchJob &job, const LoadedInput *input, QString *errorExtra)
+{
+    const QByteArray &data = input->inputFileArray;
+    const SpriteIndex &index = input->spriteIndex;
+    // The shared editor is only used for loading, options differ between jobs.
+    SpriteEditor jobEditor;
+    jobEditor.setDirectIO(job.directIO);
+    if (job.operation == "unpack") {
+        return jobEditor.unpackSprites(data, index, job.output, true);
+    } else if (job.operation == "unpackArchive") {
+        return jobEditor.unpackSpritesToArchive(data, index, job.output, true, SpriteFilter(), job.compress);
+    } else if (job.operation == "pack") {
+        return jobEditor.packSprites(data, index, job.output, job.source, errorExtra);
+    } else if (job.operation == "invisible") {
+        return jobEditor.createInvisible(data, index, job.output, errorExtra);
+    } else if (job.operation == "invisibleTrails") {
+        return jobEditor.createInvisibleTrails(data, index, job.output, errorExtra);
+    } else if (job.operation == "patch") {
+        return jobEditor.createPatch(data, index, job.source, job.output, true);
+    } else if (job.operation == "atlas") {
+        return jobEditor.exportAtlases(data, index, job.output, BATCH_ATLAS_SIZE, true);
+    } else if (job.operation == "catalog") {
+        return jobEditor.exportCatalog(index, job.output);
+    } else if (job.operation == "fingerprints") {
+        return jobEditor.exportFingerprints(data, index, job.output);
+    }
+    *errorExtra = job.operation;
+    return SER_ERROR_INTERNAL;
+}
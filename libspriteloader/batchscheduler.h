@@ -0,0 +1,62 @@
+#ifndef BATCHSCHEDULER_H
+#define BATCHSCHEDULER_H
+
+#include "spriteeditor.h"
+#include "spriteindex.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSemaphore>
+#include <QString>
+#include <memory>
+#include <vector>
+
+// One operation on one input .dat. The source is the sprite directory or archive for pack
+// and the packed .dat for patch, other operations ignore it. directIO only affects
+// operations writing a full .dat, compress only unpacking into an archive.
+struct BatchJob {
+    QString inputFilename;
+    QString operation;
+    QString source;
+    QString output;
+    bool directIO;
+    bool compress;
+};
+
+struct BatchResult {
+    enum SpriteEditorReturn result;
+    QString errorExtra;
+    qint64 elapsedMilliseconds;
+};
+
+// Runs jobs concurrently on the global thread pool. Jobs on the same input share a single
+// load and scan, which is released once the last of them finishes. At most
+// maximumConcurrentLoads inputs are read from disk at a time, and at most
+// maximumConcurrentJobs jobs run at a time, bounding the outputs held in memory and the
+// writes in flight.
+class BatchScheduler
+{
+public:
+    BatchScheduler(int maximumConcurrentLoads, int maximumConcurrentJobs);
+    static bool parseJobs(const QByteArray &json, std::vector<BatchJob> *jobs);
+    std::vector<BatchResult> run(const std::vector<BatchJob> &jobs);
+
+private:
+    struct LoadedInput {
+        QMutex mutex;
+        bool isLoaded;
+        int remainingJobs;
+        enum SpriteEditorReturn result;
+        QByteArray inputFileArray;
+        SpriteIndex spriteIndex;
+    };
+    BatchResult runJob(const BatchJob &job, LoadedInput *input);
+    enum SpriteEditorReturn runOperation(const BatchJob &job, const LoadedInput *input, QString *errorExtra);
+
+    SpriteEditor spriteEditor;
+    QSemaphore loadSemaphore;
+    QSemaphore jobSemaphore;
+};
+
+#endif // BATCHSCHEDULER_H
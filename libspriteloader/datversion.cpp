@@ -0,0 +1,149 @@
+#include "datversion.h"
+#include "fnv1a.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <algorithm>
+
+#define FINGERPRINT_BLOCK_COUNT 64
+#define FINGERPRINT_BLOCK_SIZE 4096
+#define FINGERPRINT_PNG_COUNT 16
+
+// Cached layouts are magic "SLLY", version and count, then the offset and length of every slot.
+#define INDEX_CACHE_PREFIX "layout-"
+#define INDEX_CACHE_SUFFIX ".sllay"
+#define LAYOUT_MAGIC 0x534c4c59
+#define LAYOUT_VERSION 1
+// Layouts of this many builds are kept, the oldest are removed when another is added.
+#define INDEX_CACHE_LIMIT 8
+
+static uint64_t fnv1aUpdate32(uint64_t hash, quint32 value)
+{
+    uchar bigEndian[sizeof(quint32)];
+    qToBigEndian<quint32>(value, bigEndian);
+    return fnv1aUpdate(hash, (const char *) bigEndian, sizeof(quint32));
+}
+
+
+uint64_t DatVersion::fingerprint(const QByteArray &inputFileArray)
+{
+    const char *data = inputFileArray.constData();
+    int length = inputFileArray.size();
+    uint64_t hash = fnv1aUpdate32(FNV_OFFSET_BASIS, length);
+
+    // The first and last blocks are always included, the rest are spread evenly between.
+    int blockLength = std::min(length, FINGERPRINT_BLOCK_SIZE);
+    for (int i = 0; i < FINGERPRINT_BLOCK_COUNT; i++) {
+        qint64 offset = (qint64) (length - blockLength) * i / (FINGERPRINT_BLOCK_COUNT - 1);
+        hash = fnv1aUpdate(hash, data + offset, blockLength);
+    }
+
+    int startIndex = 0;
+    int pngCount = 0;
+    bool shouldContinue = true;
+    while (shouldContinue && (pngCount < FINGERPRINT_PNG_COUNT)) {
+        bool hasFoundPNG;
+        int pngStart;
+        int pngLength;
+        uint32_t chunkCount;
+        uint32_t slack;
+        shouldContinue = SpriteIndex::findPNG(inputFileArray, startIndex, &hasFoundPNG, &pngStart, &pngLength, &chunkCount, &slack);
+        if (hasFoundPNG) {
+            hash = fnv1aUpdate32(hash, pngStart);
+            hash = fnv1aUpdate32(hash, pngLength);
+            pngCount++;
+        }
+        startIndex = pngStart + pngLength;
+    }
+    return hash;
+}
+
+
+// Returns the index of the input, using the cached slot layout when this build has been
+// indexed before. Only offsets and lengths are cached, everything else is read from the
+// input itself, so a modified file with the same fingerprint still gets its own metadata.
+// A layout which doesn't fit the input is rebuilt by a full scan.
+SpriteIndex DatVersion::cachedIndex(const QByteArray &inputFileArray)
+{
+    QString filename = cacheFilename(fingerprint(inputFileArray));
+    QFile cacheFile(filename);
+    if (cacheFile.open(QIODevice::ReadOnly)) {
+        SpriteIndex spriteIndex;
+        std::vector<int> offsets;
+        std::vector<int> lengths;
+        bool isValid = readLayout(cacheFile.readAll(), &offsets, &lengths) && SpriteIndex::fromLayout(inputFileArray, offsets, lengths, &spriteIndex);
+        cacheFile.close();
+        if (isValid) {
+            return spriteIndex;
+        }
+    }
+
+    SpriteIndex spriteIndex = SpriteIndex::build(inputFileArray);
+    if (!spriteIndex.isEmpty() && QDir().mkpath(QFileInfo(filename).absolutePath())) {
+        // Failing to cache only costs the next load a rebuild.
+        QSaveFile saveFile(filename);
+        if (saveFile.open(QIODevice::WriteOnly)) {
+            saveFile.write(writeLayout(spriteIndex));
+            if (saveFile.commit()) {
+                pruneCache(QFileInfo(filename).absoluteDir());
+            }
+        }
+    }
+    return spriteIndex;
+}
+
+
+void DatVersion::pruneCache(const QDir &cacheDirectory)
+{
+    QStringList filters;
+    filters << INDEX_CACHE_PREFIX "*" INDEX_CACHE_SUFFIX;
+    QFileInfoList cacheFiles = cacheDirectory.entryInfoList(filters, QDir::Files, QDir::Time);
+    for (int i = INDEX_CACHE_LIMIT; i < cacheFiles.size(); i++) {
+        QFile::remove(cacheFiles[i].absoluteFilePath());
+    }
+}
+
+
+QString DatVersion::cacheFilename(uint64_t fingerprint)
+{
+    QDir cacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    return cacheDirectory.absoluteFilePath(INDEX_CACHE_PREFIX + QString::number(fingerprint, 16) + INDEX_CACHE_SUFFIX);
+}
+
+
+QByteArray DatVersion::writeLayout(const SpriteIndex &spriteIndex)
+{
+    QByteArray layout;
+    QDataStream layoutStream(&layout, QIODevice::WriteOnly);
+    layoutStream << (quint32) LAYOUT_MAGIC << (quint32) LAYOUT_VERSION << (quint32) spriteIndex.size();
+    for (uint32_t i = 0; i < spriteIndex.size(); i++) {
+        layoutStream << (qint32) spriteIndex.offset(i) << (qint32) spriteIndex.length(i);
+    }
+    return layout;
+}
+
+
+bool DatVersion::readLayout(const QByteArray &layout, std::vector<int> *offsets, std::vector<int> *lengths)
+{
+    QDataStream layoutStream(layout);
+    quint32 magic, version, count;
+    layoutStream >> magic >> version >> count;
+    if ((layoutStream.status() != QDataStream::Ok) || (magic != LAYOUT_MAGIC) || (version != LAYOUT_VERSION)) {
+        return false;
+    }
+    for (quint32 i = 0; i < count; i++) {
+        qint32 offset, length;
+        layoutStream >> offset >> length;
+        if (layoutStream.status() != QDataStream::Ok) {
+            return false;
+        }
+        offsets->push_back(offset);
+        lengths->push_back(length);
+    }
+    return true;
+}
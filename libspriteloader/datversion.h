@@ -0,0 +1,29 @@
+#ifndef DATVERSION_H
+#define DATVERSION_H
+
+#include "spriteindex.h"
+
+#include <QByteArray>
+#include <QDir>
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+// Tells builds apart by a sampled fingerprint: hashes of evenly spaced fixed size blocks and
+// the offsets and lengths of the first PNGs. It reads a few hundred kilobytes instead of the
+// whole file, so it is cheap enough to run on every load. Used as the key of the slot layout
+// cache, it is not precise enough to decide whether patches apply.
+class DatVersion
+{
+public:
+    static uint64_t fingerprint(const QByteArray &inputFileArray);
+    static SpriteIndex cachedIndex(const QByteArray &inputFileArray);
+
+private:
+    static QString cacheFilename(uint64_t fingerprint);
+    static void pruneCache(const QDir &cacheDirectory);
+    static QByteArray writeLayout(const SpriteIndex &spriteIndex);
+    static bool readLayout(const QByteArray &layout, std::vector<int> *offsets, std::vector<int> *lengths);
+};
+
+#endif // DATVERSION_H
@@ -0,0 +1,140 @@
+#include "datwriter.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define WRITE_BLOCK_SIZE (4 << 20)
+#define DIRECT_IO_ALIGNMENT 4096
+#define TEMPORARY_SUFFIX ".part"
+
+#ifdef Q_OS_LINUX
+
+// Makes the rename itself durable.
+static void syncDirectory(const QString &filename)
+{
+    int directoryDescriptor = open(QFile::encodeName(QFileInfo(filename).absolutePath()).constData(), O_RDONLY | O_CLOEXEC);
+    if (directoryDescriptor >= 0) {
+        fsync(directoryDescriptor);
+        close(directoryDescriptor);
+    }
+}
+
+
+// Writes in large blocks from an aligned buffer, which O_DIRECT requires. If the filesystem
+// refuses O_DIRECT the rest is written through the page cache, which is dropped afterwards.
+static bool writeDescriptor(int fileDescriptor, const char *data, qint64 length, bool isDirect)
+{
+    char *alignedBuffer = NULL;
+    if (isDirect && (posix_memalign((void **) &alignedBuffer, DIRECT_IO_ALIGNMENT, WRITE_BLOCK_SIZE) != 0)) {
+        return false;
+    }
+
+    qint64 position = 0;
+    bool isPadded = false;
+    while (position < length) {
+        int blockLength = (int) std::min<qint64>(WRITE_BLOCK_SIZE, length - position);
+        const char *block = data + position;
+        int writeLength = blockLength;
+        if (isDirect) {
+            writeLength = (blockLength + DIRECT_IO_ALIGNMENT - 1) & ~(DIRECT_IO_ALIGNMENT - 1);
+            memcpy(alignedBuffer, block, blockLength);
+            memset(alignedBuffer + blockLength, 0, writeLength - blockLength);
+            block = alignedBuffer;
+        }
+        ssize_t bytesWritten = pwrite(fileDescriptor, block, writeLength, position);
+        if ((bytesWritten < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if ((bytesWritten < 0) && (errno == EINVAL) && isDirect) {
+            fcntl(fileDescriptor, F_SETFL, fcntl(fileDescriptor, F_GETFL) & ~O_DIRECT);
+            isDirect = false;
+            continue;
+        }
+        if ((bytesWritten <= 0) || (isDirect && (bytesWritten != writeLength))) {
+            free(alignedBuffer);
+            return false;
+        }
+        isPadded = isPadded || (writeLength > blockLength);
+        position += std::min<qint64>(bytesWritten, blockLength);
+    }
+    free(alignedBuffer);
+
+    if (isPadded && (ftruncate(fileDescriptor, length) != 0)) {
+        return false;
+    }
+    if (fsync(fileDescriptor) != 0) {
+        return false;
+    }
+    if (!isDirect) {
+        posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    return true;
+}
+
+#endif
+
+
+// With directIO the page cache is bypassed where the filesystem allows it, so writing many
+// outputs does not evict everything else. Other platforms use QSaveFile, which also syncs
+// and renames, but writes through the cache.
+bool DatWriter::write(const QString &filename, const char *data, qint64 length, bool directIO)
+{
+#ifdef Q_OS_LINUX
+    QByteArray temporaryName = QFile::encodeName(filename + TEMPORARY_SUFFIX);
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    int fileDescriptor = -1;
+    bool isDirect = directIO;
+    if (isDirect) {
+        fileDescriptor = open(temporaryName.constData(), flags | O_DIRECT, 0666);
+        isDirect = (fileDescriptor >= 0);
+    }
+    if (fileDescriptor < 0) {
+        fileDescriptor = open(temporaryName.constData(), flags, 0666);
+    }
+    if (fileDescriptor < 0) {
+        return false;
+    }
+
+    // Filesystems without fallocate still work, only running out of space is an error.
+    if ((fallocate(fileDescriptor, 0, 0, length) != 0) && (errno == ENOSPC)) {
+        close(fileDescriptor);
+        unlink(temporaryName.constData());
+        return false;
+    }
+
+    bool isWritten = writeDescriptor(fileDescriptor, data, length, isDirect);
+    isWritten = (close(fileDescriptor) == 0) && isWritten;
+    if (!isWritten || (rename(temporaryName.constData(), QFile::encodeName(filename).constData()) != 0)) {
+        unlink(temporaryName.constData());
+        return false;
+    }
+    syncDirectory(filename);
+    return true;
+#else
+    Q_UNUSED(directIO);
+    QSaveFile outputFile(filename);
+    if (!outputFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    qint64 position = 0;
+    while (position < length) {
+        qint64 bytesWritten = outputFile.write(data + position, std::min<qint64>(WRITE_BLOCK_SIZE, length - position));
+        if (bytesWritten <= 0) {
+            outputFile.cancelWriting();
+            break;
+        }
+        position += bytesWritten;
+    }
+    return outputFile.commit();
+#endif
+}
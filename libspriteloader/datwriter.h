@@ -0,0 +1,14 @@
+#ifndef DATWRITER_H
+#define DATWRITER_H
+
+#include <QString>
+
+// Writes a whole output file through a preallocated temporary file which is synced and then
+// renamed over the target, so a crash never leaves a partially written file behind.
+class DatWriter
+{
+public:
+    static bool write(const QString &filename, const char *data, qint64 length, bool directIO);
+};
+
+#endif // DATWRITER_H
@@ -0,0 +1,24 @@
+#ifndef FNV1A_H
+#define FNV1A_H
+
+#include <cstdint>
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+// 64 bit FNV-1a, continued from a previous hash so separate ranges can be combined.
+static inline uint64_t fnv1aUpdate(uint64_t hash, const char *data, int length)
+{
+    for (int i = 0; i < length; i++) {
+        hash ^= (uint8_t) data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static inline uint64_t fnv1aHash(const char *data, int length)
+{
+    return fnv1aUpdate(FNV_OFFSET_BASIS, data, length);
+}
+
+#endif // FNV1A_H
@@ -0,0 +1,41 @@
+TEMPLATE = lib
+TARGET = spriteloader
+
+QT       += core gui concurrent
+
+CONFIG += c++11 staticlib
+
+# The following define makes your compiler emit warnings if you use
+# any Qt feature that has been marked deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    atlaspacker.cpp \
+    batchscheduler.cpp \
+    crc32.cpp \
+    datversion.cpp \
+    datwriter.cpp \
+    pngfitter.cpp \
+    spritearchive.cpp \
+    spriteeditor.cpp \
+    spritefilter.cpp \
+    spriteindex.cpp \
+    streamingscanner.cpp
+
+HEADERS += \
+    atlaspacker.h \
+    batchscheduler.h \
+    crc32.h \
+    datversion.h \
+    datwriter.h \
+    fnv1a.h \
+    invisible.h \
+    pngfitter.h \
+    pngformat.h \
+    spritearchive.h \
+    spriteeditor.h \
+    spritefilter.h \
+    spriteindex.h \
+    streamingscanner.h
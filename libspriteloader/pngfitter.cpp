@@ -0,0 +1,155 @@
+#include "pngfitter.h"
+#include "pngformat.h"
+#include "spriteindex.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QImageWriter>
+#include <QSet>
+#include <QVector>
+#include <QtConcurrent>
+#include <vector>
+
+#define PALETTE_MAXIMUM_COLORS 256
+
+// QImageWriter quality for PNG, lower is stronger zlib compression.
+static const int encodeQualities[] = {0, 30};
+#define ENCODE_QUALITY_COUNT 2
+
+struct FitCandidate {
+    int order;
+    QImage image;
+    int quality;
+    QByteArray output;
+};
+
+
+// A replacement either has exactly the slot length or leaves room for a padding chunk.
+bool PNGFitter::fitsSlot(int pngLength, int slotLength)
+{
+    return (pngLength == slotLength) || (pngLength < slotLength - MINIMUM_PAD_AMOUNT);
+}
+
+
+// Tries, in order, stripping ancillary chunks and then re-encoding in every lossless colour
+// mode and compression level in parallel. Returns the first result which fits, or an empty
+// array if none do.
+QByteArray PNGFitter::fit(const QByteArray &pngArray, int slotLength)
+{
+    QByteArray stripped = stripAncillaryChunks(pngArray);
+    if (!stripped.isEmpty() && fitsSlot(stripped.size(), slotLength)) {
+        return stripped;
+    }
+
+    QImage original = QImage::fromData(pngArray, "PNG");
+    // Comparisons below are done at 8 bits per channel, deeper images can't be checked.
+    if (original.isNull() || (original.depth() > 32)) {
+        return QByteArray();
+    }
+    QImage reference = original.convertToFormat(QImage::Format_ARGB32);
+
+    bool isOpaque = true;
+    bool isGray = true;
+    QSet<QRgb> colors;
+    for (int y = 0; y < reference.height(); y++) {
+        const QRgb *line = (const QRgb *) reference.constScanLine(y);
+        for (int x = 0; x < reference.width(); x++) {
+            if (qAlpha(line[x]) != 255) {
+                isOpaque = false;
+            }
+            if ((qRed(line[x]) != qGreen(line[x])) || (qGreen(line[x]) != qBlue(line[x]))) {
+                isGray = false;
+            }
+            if (colors.size() <= PALETTE_MAXIMUM_COLORS) {
+                colors.insert(line[x]);
+            }
+        }
+    }
+
+    std::vector<QImage> images;
+    images.push_back(reference);
+    if (isOpaque) {
+        images.push_back(reference.convertToFormat(QImage::Format_RGB32));
+        if (isGray) {
+            images.push_back(reference.convertToFormat(QImage::Format_Grayscale8));
+        }
+    }
+    if (colors.size() <= PALETTE_MAXIMUM_COLORS) {
+        QVector<QRgb> colorTable;
+        for (QRgb color : colors) {
+            colorTable.append(color);
+        }
+        images.push_back(reference.convertToFormat(QImage::Format_Indexed8, colorTable, Qt::ThresholdDither | Qt::AvoidDither));
+    }
+
+    std::vector<FitCandidate> candidates;
+    for (uint32_t i = 0; i < images.size(); i++) {
+        for (int q = 0; q < ENCODE_QUALITY_COUNT; q++) {
+            candidates.push_back({(int) candidates.size(), images[i], encodeQualities[q], QByteArray()});
+        }
+    }
+    // Candidates after the first one found to fit are skipped, those before it still run so
+    // the result is the same as trying them in order.
+    int candidateCount = candidates.size();
+    QAtomicInt firstFit(candidateCount);
+    QtConcurrent::blockingMap(candidates, [&](FitCandidate &candidate) {
+        if (candidate.order > firstFit.loadAcquire()) {
+            return;
+        }
+        QByteArray encoded;
+        QBuffer buffer(&encoded);
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "png");
+        writer.setQuality(candidate.quality);
+        if (!writer.write(candidate.image)) {
+            return;
+        }
+        // QImage carries the original's text keys and resolution through conversions and the
+        // writer adds them back, so they are stripped again.
+        encoded = stripAncillaryChunks(encoded);
+        if (encoded.isEmpty() || !fitsSlot(encoded.size(), slotLength)) {
+            return;
+        }
+        // Only keep encodings which decode to exactly the same pixels.
+        QImage decoded = QImage::fromData(encoded, "PNG").convertToFormat(QImage::Format_ARGB32);
+        if (decoded != reference) {
+            return;
+        }
+        candidate.output = encoded;
+        int current = firstFit.loadAcquire();
+        while ((candidate.order < current) && !firstFit.testAndSetOrdered(current, candidate.order)) {
+            current = firstFit.loadAcquire();
+        }
+    });
+
+    int fitIndex = firstFit.loadAcquire();
+    if (fitIndex == candidateCount) {
+        return QByteArray();
+    }
+    return candidates[fitIndex].output;
+}
+
+
+// Keeps only the chunks needed to decode the pixels: IHDR, PLTE, tRNS, IDAT and IEND.
+// Returns an empty array if the PNG can't be parsed.
+QByteArray PNGFitter::stripAncillaryChunks(const QByteArray &pngArray)
+{
+    if ((pngArray.size() < PNG_HEADER_LENGTH) || !pngArray.startsWith(QByteArray(pngHeader, PNG_HEADER_LENGTH))) {
+        return QByteArray();
+    }
+    QByteArray output = pngArray.left(PNG_HEADER_LENGTH);
+    int index = PNG_HEADER_LENGTH;
+    uint32_t chunkType = 0;
+    int chunkLength;
+    while (chunkType != PNG_IEND) {
+        if (!SpriteIndex::processChunk(pngArray, index, &chunkType, &chunkLength)) {
+            return QByteArray();
+        }
+        if ((chunkType == PNG_IHDR) || (chunkType == PNG_PLTE) || (chunkType == PNG_tRNS) ||
+                (chunkType == PNG_IDAT) || (chunkType == PNG_IEND)) {
+            output.append(pngArray.constData() + index, chunkLength);
+        }
+        index += chunkLength;
+    }
+    return output;
+}
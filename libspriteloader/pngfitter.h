@@ -0,0 +1,15 @@
+#ifndef PNGFITTER_H
+#define PNGFITTER_H
+
+#include <QByteArray>
+
+// Shrinks a replacement PNG without changing its pixels, so it fits a slot it is too large for.
+class PNGFitter
+{
+public:
+    static bool fitsSlot(int pngLength, int slotLength);
+    static QByteArray fit(const QByteArray &pngArray, int slotLength);
+    static QByteArray stripAncillaryChunks(const QByteArray &pngArray);
+};
+
+#endif // PNGFITTER_H
@@ -0,0 +1,38 @@
+#ifndef PNGFORMAT_H
+#define PNGFORMAT_H
+
+#include <cstdint>
+
+#define PNG_HEADER_LENGTH 8
+#define PNG_TYPE_COUNT 21
+#define MINIMUM_PAD_AMOUNT 15
+#define IEND_SIZE 12
+
+// Offsets of the IHDR fields from the start of a PNG, the IHDR is always the first chunk.
+#define IHDR_LENGTH_OFFSET 8
+#define IHDR_WIDTH_OFFSET 16
+#define IHDR_HEIGHT_OFFSET 20
+#define IHDR_BIT_DEPTH_OFFSET 24
+#define IHDR_COLOR_TYPE_OFFSET 25
+#define IHDR_INTERLACE_OFFSET 28
+#define IHDR_DATA_LENGTH 13
+
+static const char pngHeader[] = "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a";
+
+enum PNGTypes:uint32_t {PNG_IHDR=1229472850, PNG_PLTE=1347179589, PNG_IDAT=1229209940,
+                        PNG_IEND=1229278788, PNG_bKGD=1649100612, PNG_cHRM=1665684045,
+                        PNG_dSIG=1683179847, PNG_eXIf=1700284774, PNG_gAMA=1732332865,
+                        PNG_hIST=1749635924, PNG_iCCP=1766015824, PNG_iTXt=1767135348,
+                        PNG_pHYs=1883789683, PNG_sBIT=1933723988, PNG_sPLT=1934642260,
+                        PNG_sRGB=1934772034, PNG_sTER=1934902610, PNG_tEXt=1950701684,
+                        PNG_tIME=1950960965, PNG_tRNS=1951551059, PNG_zTXt=2052348020};
+
+static const uint32_t pngTypes[] = {PNG_IHDR, PNG_PLTE, PNG_IDAT,
+                                    PNG_IEND, PNG_bKGD, PNG_cHRM,
+                                    PNG_dSIG, PNG_eXIf, PNG_gAMA,
+                                    PNG_hIST, PNG_iCCP, PNG_iTXt,
+                                    PNG_pHYs, PNG_sBIT, PNG_sPLT,
+                                    PNG_sRGB, PNG_sTER, PNG_tEXt,
+                                    PNG_tIME, PNG_tRNS, PNG_zTXt};
+
+#endif // PNGFORMAT_H
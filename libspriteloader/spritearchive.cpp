@@ -0,0 +1,191 @@
+#include "spritearchive.h"
+
+#include <QDataStream>
+
+// Layout is an 8 byte header (magic "SLAR", version), the entry data, the index and then a
+// 16 byte trailer (index offset, entry count, magic "SLAI"). Each index entry is the sprite
+// index, offset, stored length, original length and flags.
+#define ARCHIVE_MAGIC 0x534c4152
+#define ARCHIVE_INDEX_MAGIC 0x534c4149
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_HEADER_LENGTH 8
+#define ARCHIVE_TRAILER_LENGTH 16
+#define ARCHIVE_FLAG_COMPRESSED 1
+
+SpriteArchive::SpriteArchive()
+{
+
+}
+
+
+SpriteArchive::~SpriteArchive()
+{
+    close();
+}
+
+
+bool SpriteArchive::create(QString filename)
+{
+    close();
+    saveFile.setFileName(filename);
+    if (!saveFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream headerStream(&saveFile);
+    headerStream << (quint32) ARCHIVE_MAGIC << (quint32) ARCHIVE_VERSION;
+    if (headerStream.status() != QDataStream::Ok) {
+        cancel();
+        return false;
+    }
+    return true;
+}
+
+
+bool SpriteArchive::append(uint32_t spriteIndex, const char *data, int length, bool compress)
+{
+    Entry entry;
+    entry.offset = saveFile.pos();
+    entry.length = length;
+    entry.flags = 0;
+    QByteArray compressed;
+    if (compress) {
+        compressed = qCompress((const uchar *) data, length);
+        // Already compressed PNGs often don't shrink, keep those as they are.
+        if (compressed.size() < length) {
+            data = compressed.constData();
+            length = compressed.size();
+            entry.flags |= ARCHIVE_FLAG_COMPRESSED;
+        }
+    }
+    entry.storedLength = length;
+    if (saveFile.write(data, length) < length) {
+        return false;
+    }
+    entries.insert(spriteIndex, entry);
+    return true;
+}
+
+
+// Writes the index and replaces any existing archive, nothing is replaced if any write failed.
+bool SpriteArchive::finish()
+{
+    quint64 indexOffset = saveFile.pos();
+    QDataStream indexStream(&saveFile);
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        indexStream << (quint32) it.key() << it->offset << it->storedLength << it->length << it->flags;
+    }
+    indexStream << indexOffset << (quint32) entries.size() << (quint32) ARCHIVE_INDEX_MAGIC;
+    if ((indexStream.status() != QDataStream::Ok) || !saveFile.flush()) {
+        saveFile.cancelWriting();
+    }
+    bool isSuccess = saveFile.commit();
+    entries.clear();
+    return isSuccess;
+}
+
+
+// Discards an archive being written, an existing file of the same name is left untouched.
+void SpriteArchive::cancel()
+{
+    if (saveFile.isOpen()) {
+        saveFile.cancelWriting();
+        saveFile.commit();
+    }
+    entries.clear();
+}
+
+
+// Reads only the header and the trailing index, entries are read on demand.
+bool SpriteArchive::open(QString filename)
+{
+    close();
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    qint64 fileSize = file.size();
+    if (fileSize < ARCHIVE_HEADER_LENGTH + ARCHIVE_TRAILER_LENGTH) {
+        close();
+        return false;
+    }
+    QDataStream archiveStream(&file);
+    quint32 magic, version;
+    archiveStream >> magic >> version;
+    if ((magic != ARCHIVE_MAGIC) || (version != ARCHIVE_VERSION)) {
+        close();
+        return false;
+    }
+
+    quint64 indexOffset;
+    quint32 entryCount, indexMagic;
+    file.seek(fileSize - ARCHIVE_TRAILER_LENGTH);
+    archiveStream >> indexOffset >> entryCount >> indexMagic;
+    if ((archiveStream.status() != QDataStream::Ok) || (indexMagic != ARCHIVE_INDEX_MAGIC) ||
+            (indexOffset > (quint64) (fileSize - ARCHIVE_TRAILER_LENGTH))) {
+        close();
+        return false;
+    }
+
+    file.seek(indexOffset);
+    for (quint32 i = 0; i < entryCount; i++) {
+        quint32 spriteIndex;
+        Entry entry;
+        archiveStream >> spriteIndex >> entry.offset >> entry.storedLength >> entry.length >> entry.flags;
+        if ((archiveStream.status() != QDataStream::Ok) || (entry.offset + entry.storedLength > indexOffset)) {
+            close();
+            return false;
+        }
+        entries.insert(spriteIndex, entry);
+    }
+    return true;
+}
+
+
+std::vector<uint32_t> SpriteArchive::spriteIndices() const
+{
+    std::vector<uint32_t> indices;
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        indices.push_back(it.key());
+    }
+    return indices;
+}
+
+
+bool SpriteArchive::contains(uint32_t spriteIndex) const
+{
+    return entries.contains(spriteIndex);
+}
+
+
+bool SpriteArchive::read(uint32_t spriteIndex, QByteArray *output)
+{
+    auto found = entries.constFind(spriteIndex);
+    if (found == entries.constEnd()) {
+        return false;
+    }
+    if (!file.seek(found->offset)) {
+        return false;
+    }
+    QByteArray stored = file.read(found->storedLength);
+    if (stored.size() != (int) found->storedLength) {
+        return false;
+    }
+    if (found->flags & ARCHIVE_FLAG_COMPRESSED) {
+        stored = qUncompress(stored);
+    }
+    if (stored.size() != (int) found->length) {
+        return false;
+    }
+    *output = stored;
+    return true;
+}
+
+
+void SpriteArchive::close()
+{
+    cancel();
+    if (file.isOpen()) {
+        file.close();
+    }
+    entries.clear();
+}
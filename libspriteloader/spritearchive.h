@@ -0,0 +1,45 @@
+#ifndef SPRITEARCHIVE_H
+#define SPRITEARCHIVE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMap>
+#include <QSaveFile>
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+// A single file holding many sprites, written sequentially with the index at the end so
+// that any sprite can be read back with one seek. Entries may be zlib compressed. A new
+// archive only replaces an existing one once finish() succeeds.
+class SpriteArchive
+{
+public:
+    SpriteArchive();
+    ~SpriteArchive();
+
+    bool create(QString filename);
+    bool append(uint32_t spriteIndex, const char *data, int length, bool compress);
+    bool finish();
+    void cancel();
+
+    bool open(QString filename);
+    std::vector<uint32_t> spriteIndices() const;
+    bool contains(uint32_t spriteIndex) const;
+    bool read(uint32_t spriteIndex, QByteArray *output);
+
+    void close();
+
+private:
+    struct Entry {
+        quint64 offset;
+        quint32 storedLength;
+        quint32 length;
+        quint32 flags;
+    };
+    QSaveFile saveFile;
+    QFile file;
+    QMap<uint32_t, Entry> entries;
+};
+
+#endif // SPRITEARCHIVE_H
@@ -0,0 +1,1424 @@
+#include "spriteeditor.h"
+#include "crc32.h"
+#include "datversion.h"
+#include "datwriter.h"
+#include "fnv1a.h"
+#include "invisible.h"
+#include "pngformat.h"
+#include "atlaspacker.h"
+#include "spritearchive.h"
+#include "pngfitter.h"
+#include "streamingscanner.h"
+
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+#include <QtEndian>
+#include <cstring>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QHash>
+#include <QImage>
+#include <QBuffer>
+#include <QImageWriter>
+#include <QPainter>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtConcurrent>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <algorithm>
+
+
+
+// Patch files are a 20 byte header (magic "SLPT", version, flags, dat length, entry count)
+// followed by the entries, each being slot index, offset, length, CRC of the original slot
+// and the padded slot contents.
+#define PATCH_MAGIC 0x534c5054
+#define PATCH_VERSION 2
+#define PATCH_HEADER_LENGTH 20
+#define PATCH_FLAG_COMPRESSED 1
+
+// Fingerprint databases are magic "SLFP", version and count, then per sprite the
+// 64 bit FNV-1a hash of the PNG bytes and the IHDR width and height.
+#define FINGERPRINT_MAGIC 0x534c4650
+#define FINGERPRINT_VERSION 1
+
+#define ATLAS_PADDING 1
+#define ATLAS_MANIFEST_FILENAME "atlas.json"
+
+// Failing sprites named in a verification error, the rest are only counted.
+#define VERIFY_REPORT_LIMIT 10
+
+// Sprites read from a stream but not yet written, bounding memory when writes are slower.
+#define STREAM_PENDING_WRITES 64
+// Longest PNG accepted from a stream, which bounds how much of it is buffered.
+#define STREAM_MAXIMUM_PNG_LENGTH (8 << 20)
+
+static uint32_t readBigEndian32(const char *data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(uint32_t));
+    return qFromBigEndian<quint32>(value);
+}
+
+SpriteEditor::SpriteEditor()
+{
+    useDirectIO = false;
+}
+
+
+void SpriteEditor::setDirectIO(bool directIO)
+{
+    useDirectIO = directIO;
+}
+
+
+enum SpriteEditorReturn SpriteEditor::loadInput(QString inputFilename, QByteArray *inputFileArray, SpriteIndex *spriteIndex) const
+{
+    QFile inputFile(inputFilename);
+    if (!inputFile.open(QIODevice::ReadOnly)) {
+        return SER_ERROR_INPUT_FILE;
+    }
+    *inputFileArray = inputFile.readAll();
+    inputFile.close();
+    if (inputFileArray->length() != GAMEDATA_DAT_LENGTH) {
+        return SER_ERROR_INPUT_FILE;
+    }
+
+    *spriteIndex = DatVersion::cachedIndex(*inputFileArray);
+    if (spriteIndex->isEmpty()) {
+        return SER_ERROR_INPUT_FILE;
+    }
+    return SER_SUCCESS;
+}
+
+
+// Wraps a buffer owned by the caller without copying it, the buffer must outlive the
+// returned array and index. Always scans, the index cache on disk is only used for files.
+enum SpriteEditorReturn SpriteEditor::loadInput(const char *data, int length, QByteArray *inputFileArray, SpriteIndex *spriteIndex) const
+{
+    if (length != GAMEDATA_DAT_LENGTH) {
+        return SER_ERROR_INPUT_FILE;
+    }
+    *inputFileArray = QByteArray::fromRawData(data, length);
+    *spriteIndex = SpriteIndex::build(*inputFileArray);
+    if (spriteIndex->isEmpty()) {
+        return SER_ERROR_INPUT_FILE;
+    }
+    return SER_SUCCESS;
+}
+
+
+// Returns a view of the sprite inside the input, valid for as long as the input is.
+QByteArray SpriteEditor::getSprite(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, uint32_t index) const
+{
+    if (index >= spriteIndex.size()) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(inputFileArray.constData() + spriteIndex.offset(index), spriteIndex.length(index));
+}
+
+
+// Applies PNG replacements keyed by sprite index and returns the packed .dat in outputArray.
+// On failure errorIndex is the sprite which could not be packed, or errorExtra lists the
+// sprites which failed verification. outputArray is only set once the output verifies.
+enum SpriteEditorReturn SpriteEditor::packSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, const QMap<uint32_t, QByteArray> &replacements, QByteArray *outputArray, uint32_t *errorIndex, QString *errorExtra) const
+{
+    QByteArray output(inputFileArray.constData(), inputFileArray.size());
+    char *outputData = output.data();
+    for (auto it = replacements.constBegin(); it != replacements.constEnd(); ++it) {
+        if (it.key() >= spriteIndex.size()) {
+            *errorIndex = it.key();
+            return SER_ERROR_INPUT_PNG;
+        }
+        enum SpriteEditorReturn result = replaceSprite(outputData, spriteIndex, it.key(), it.value());
+        if (result != SER_SUCCESS) {
+            *errorIndex = it.key();
+            return result;
+        }
+    }
+    enum SpriteEditorReturn result = verifyOutput(inputFileArray, spriteIndex, output.constData(), errorExtra);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    *outputArray = output;
+    return SER_SUCCESS;
+}
+
+
+enum SpriteEditorReturn SpriteEditor::packSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, const QMap<uint32_t, QImage> &replacements, QByteArray *outputArray, uint32_t *errorIndex, QString *errorExtra) const
+{
+    QMap<uint32_t, QByteArray> encodedReplacements;
+    for (auto it = replacements.constBegin(); it != replacements.constEnd(); ++it) {
+        QByteArray pngArray;
+        QBuffer pngBuffer(&pngArray);
+        pngBuffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&pngBuffer, "png");
+        if (!writer.write(it.value())) {
+            *errorIndex = it.key();
+            return SER_ERROR_INPUT_PNG;
+        }
+        encodedReplacements.insert(it.key(), pngArray);
+    }
+    return packSprites(inputFileArray, spriteIndex, encodedReplacements, outputArray, errorIndex, errorExtra);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::unpackSprites(QString inputFilename, QString outputDirectory, bool overwriteFiles) const
+{
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    enum SpriteEditorReturn result = loadInput(inputFilename, &inputFileArray, &spriteIndex);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    return unpackSprites(inputFileArray, spriteIndex, outputDirectory, overwriteFiles);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::unpackSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputDirectory, bool overwriteFiles) const
+{
+    return unpackSprites(inputFileArray, spriteIndex, outputDirectory, overwriteFiles, SpriteFilter(), 0);
+}
+
+
+// Only the sprites matching the filter are written, or checked for overwriting. With a
+// shard size the sprites are split into numbered subdirectories of that many sprites each.
+enum SpriteEditorReturn SpriteEditor::unpackSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputDirectory, bool overwriteFiles, const SpriteFilter &filter, int shardSize) const
+{
+    QDir directory(outputDirectory);
+    if (!directory.exists()) {
+        return SER_ERROR_OUTPUT_DIR;
+    }
+
+    std::vector<uint32_t> selected;
+    for (uint32_t i = 0; i < spriteIndex.size(); i++) {
+        if (filter.matches(spriteIndex, i)) {
+            selected.push_back(i);
+        }
+    }
+
+    // Checks if any of the images currently exists, if they do, require overwriting.
+    if (!overwriteFiles) {
+        for (uint32_t i : selected) {
+            QFileInfo testFile(getSpriteFilename(directory, i, shardSize));
+            if (testFile.exists()) {
+                return SER_ERROR_OVERWRITE;
+            }
+        }
+    }
+
+    // Create only the shards that will be written to.
+    if (shardSize > 0) {
+        int lastShard = -1;
+        for (uint32_t i : selected) {
+            int shard = i / shardSize;
+            if ((shard != lastShard) && !directory.mkpath(QString::number(shard))) {
+                return SER_ERROR_OUTPUT_DIR;
+            }
+            lastShard = shard;
+        }
+    }
+
+    // Save PNGs.
+    const char *data = inputFileArray.constData();
+    for (uint32_t i : selected) {
+        QFile outputFile(getSpriteFilename(directory, i, shardSize));
+        if (outputFile.open(QIODevice::WriteOnly)) {
+            int bytesWritten = outputFile.write(data + spriteIndex.offset(i), spriteIndex.length(i));
+            if (bytesWritten < spriteIndex.length(i)) {
+                outputFile.close();
+                return SER_ERROR_PNG_OUTPUT;
+            }
+            outputFile.close();
+        }
+    }
+
+    return SER_SUCCESS;
+}
+
+
+// Unpacks a .dat read once from start to end, such as from a pipe. Each sprite is written
+// on a writer thread while the rest of the input is still being read. Existing files are
+// only found as they are reached, so earlier sprites may already have been written.
+enum SpriteEditorReturn SpriteEditor::unpackSprites(QIODevice *inputDevice, QString outputDirectory, bool overwriteFiles) const
+{
+    QDir directory(outputDirectory);
+    if (!directory.exists()) {
+        return SER_ERROR_OUTPUT_DIR;
+    }
+
+    QThreadPool writerPool;
+    QSemaphore pendingWrites(STREAM_PENDING_WRITES);
+    QAtomicInt hasWriteFailed(0);
+    enum SpriteEditorReturn result = SER_SUCCESS;
+    uint32_t spriteCount = 0;
+
+    StreamingScanner scanner(inputDevice, STREAM_MAXIMUM_PNG_LENGTH);
+    uint32_t index;
+    qint64 offset;
+    QByteArray pngArray;
+    while (scanner.next(&index, &offset, &pngArray)) {
+        QString filename = getSpriteFilename(directory, index, 0);
+        if (!overwriteFiles && QFileInfo::exists(filename)) {
+            result = SER_ERROR_OVERWRITE;
+            break;
+        }
+        if (hasWriteFailed.loadAcquire()) {
+            break;
+        }
+        pendingWrites.acquire();
+        QtConcurrent::run(&writerPool, [filename, pngArray, &pendingWrites, &hasWriteFailed]() {
+            QFile outputFile(filename);
+            if (!outputFile.open(QIODevice::WriteOnly) || (outputFile.write(pngArray) < pngArray.size())) {
+                hasWriteFailed.storeRelease(1);
+            }
+            outputFile.close();
+            pendingWrites.release();
+        });
+        spriteCount++;
+    }
+    writerPool.waitForDone();
+
+    if (hasWriteFailed.loadAcquire()) {
+        return SER_ERROR_PNG_OUTPUT;
+    }
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    if ((spriteCount == 0) || (scanner.bytesRead() != GAMEDATA_DAT_LENGTH)) {
+        return SER_ERROR_INPUT_FILE;
+    }
+    return SER_SUCCESS;
+}
+
+
+QString SpriteEditor::getSpriteFilename(const QDir &directory, uint32_t index, int shardSize) const
+{
+    QString filename = "image" + QString::number(index) + ".png";
+    if (shardSize > 0) {
+        filename = QString::number(index / shardSize) + "/" + filename;
+    }
+    return directory.absoluteFilePath(filename);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::packSprites(QString inputFilename, QString outputFilename, QString inputDirectory, QString *errorExtra) const
+{
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    enum SpriteEditorReturn result = loadInput(inputFilename, &inputFileArray, &spriteIndex);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    return packSprites(inputFileArray, spriteIndex, outputFilename, inputDirectory, errorExtra);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::packSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, QString inputDirectory, QString *errorExtra) const
+{
+    return packSprites(inputFileArray, spriteIndex, outputFilename, inputDirectory, 0, errorExtra);
+}
+
+
+// The input directory may also be a sprite archive written by unpackSpritesToArchive.
+// The shard size must match the one the directory was unpacked with.
+enum SpriteEditorReturn SpriteEditor::packSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, QString inputDirectory, int shardSize, QString *errorExtra) const
+{
+    bool isArchive = QFileInfo(inputDirectory).isFile();
+    QDir directory(inputDirectory);
+    if (!isArchive && !directory.exists()) {
+        return SER_ERROR_INPUT_DIR;
+    }
+
+    char *outputData = (char*) malloc(inputFileArray.size());
+    if (outputData == NULL) {
+        return SER_ERROR_INTERNAL;
+    }
+    memcpy(outputData, inputFileArray.constData(), inputFileArray.size());
+
+    enum SpriteEditorReturn result;
+    if (isArchive) {
+        result = replaceSpritesFromArchive(outputData, spriteIndex, inputDirectory, errorExtra);
+    } else {
+        result = replaceSpritesFromDirectory(outputData, spriteIndex, directory, shardSize, errorExtra);
+    }
+    if (result != SER_SUCCESS) {
+        free(outputData);
+        return result;
+    }
+    result = verifyOutput(inputFileArray, spriteIndex, outputData, errorExtra);
+    if (result != SER_SUCCESS) {
+        free(outputData);
+        return result;
+    }
+
+    bool isWritten = DatWriter::write(outputFilename, outputData, GAMEDATA_DAT_LENGTH, useDirectIO);
+    free(outputData);
+    return isWritten ? SER_SUCCESS : SER_ERROR_DAT_OUTPUT;
+}
+
+
+enum SpriteEditorReturn SpriteEditor::replaceSpritesFromDirectory(char *outputData, const SpriteIndex &spriteIndex, const QDir &directory, int shardSize, QString *errorExtra) const
+{
+    if (shardSize <= 0) {
+        return replaceSpritesFromShard(outputData, spriteIndex, directory, 0, spriteIndex.size(), errorExtra);
+    }
+
+    // Only list the shards which exist and can hold a sprite of this .dat.
+    uint32_t shardCount = (spriteIndex.size() + shardSize - 1) / shardSize;
+    QStringList filters;
+    QStringList shardList = directory.entryList(filters, QDir::Dirs | QDir::NoDotAndDotDot, QDir::NoSort);
+    for (int i = 0; i < shardList.size(); i++) {
+        bool validNumber;
+        uint32_t shard = shardList[i].toUInt(&validNumber);
+        if (!validNumber || (shard >= shardCount)) {
+            continue;
+        }
+        QDir shardDirectory(directory.absoluteFilePath(shardList[i]));
+        uint32_t firstIndex = shard * shardSize;
+        enum SpriteEditorReturn result = replaceSpritesFromShard(outputData, spriteIndex, shardDirectory, firstIndex, firstIndex + shardSize, errorExtra);
+        if (result != SER_SUCCESS) {
+            return result;
+        }
+    }
+    return SER_SUCCESS;
+}
+
+
+// Replaces the sprites found in one directory, ignoring any outside [firstIndex, endIndex).
+enum SpriteEditorReturn SpriteEditor::replaceSpritesFromShard(char *outputData, const SpriteIndex &spriteIndex, const QDir &directory, uint32_t firstIndex, uint32_t endIndex, QString *errorExtra) const
+{
+    QStringList filters;
+    QStringList fileList = directory.entryList(filters, QDir::Files, QDir::NoSort);
+    for (int i = 0; i < fileList.size(); i++) {
+        QString filename = fileList[i];
+        if (filename.startsWith("image") && filename.endsWith(".png")) {
+            QString numberString = filename;
+            numberString.remove("image");
+            numberString.remove(".png");
+            bool validNumber;
+            uint32_t index = numberString.toUInt(&validNumber);
+            if (validNumber && (index >= firstIndex) && (index < endIndex) && (index < spriteIndex.size())) {
+                qDebug() << filename;
+                QString fullFilename = directory.absoluteFilePath(filename);
+                QFile inputPNG(fullFilename);
+                if (!inputPNG.open(QIODevice::ReadOnly)) {
+                    *errorExtra = filename;
+                    return SER_ERROR_INPUT_PNG;
+                }
+                QByteArray pngArray = inputPNG.readAll();
+                enum SpriteEditorReturn result = replaceSprite(outputData, spriteIndex, index, pngArray);
+                if (result != SER_SUCCESS) {
+                    *errorExtra = filename;
+                    return result;
+                }
+            }
+        }
+    }
+    return SER_SUCCESS;
+}
+
+
+enum SpriteEditorReturn SpriteEditor::replaceSpritesFromArchive(char *outputData, const SpriteIndex &spriteIndex, QString archiveFilename, QString *errorExtra) const
+{
+    SpriteArchive archive;
+    if (!archive.open(archiveFilename)) {
+        return SER_ERROR_INPUT_ARCHIVE;
+    }
+    std::vector<uint32_t> archiveIndices = archive.spriteIndices();
+    for (uint32_t index : archiveIndices) {
+        if (index >= spriteIndex.size()) {
+            continue;
+        }
+        QString filename = "image" + QString::number(index) + ".png";
+        QByteArray pngArray;
+        if (!archive.read(index, &pngArray)) {
+            *errorExtra = filename;
+            return SER_ERROR_INPUT_PNG;
+        }
+        enum SpriteEditorReturn result = replaceSprite(outputData, spriteIndex, index, pngArray);
+        if (result != SER_SUCCESS) {
+            *errorExtra = filename;
+            return result;
+        }
+    }
+    return SER_SUCCESS;
+}
+
+
+// Pads a replacement PNG to the length of its slot and copies it into the output.
+enum SpriteEditorReturn SpriteEditor::replaceSprite(char *outputData, const SpriteIndex &spriteIndex, uint32_t index, const QByteArray &pngArray) const
+{
+    enum SpriteEditorReturn result;
+    char *paddedPNG = getReplacementPNG(pngArray, spriteIndex.length(index), &result);
+    if (paddedPNG == NULL) {
+        return result;
+    }
+    memcpy(outputData + spriteIndex.offset(index), paddedPNG, spriteIndex.length(index));
+    free(paddedPNG);
+    return SER_SUCCESS;
+}
+
+
+// Writes only the given slots into an existing output .dat in place, every other byte is left
+// untouched. An empty replacement restores the slot from the input. Slots which can't be
+// replaced, or which fail verification once padded, are skipped, the first of them is
+// returned in errorIndex.
+enum SpriteEditorReturn SpriteEditor::replaceSpritesInFile(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, const QMap<uint32_t, QByteArray> &replacements, uint32_t *errorIndex) const
+{
+    QFile outputFile(outputFilename);
+    if ((outputFile.size() != GAMEDATA_DAT_LENGTH) || !outputFile.open(QIODevice::ReadWrite)) {
+        return SER_ERROR_DAT_OUTPUT;
+    }
+
+    enum SpriteEditorReturn firstError = SER_SUCCESS;
+    for (QMap<uint32_t, QByteArray>::const_iterator it = replacements.constBegin(); it != replacements.constEnd(); ++it) {
+        uint32_t index = it.key();
+        if (index >= spriteIndex.size()) {
+            continue;
+        }
+        int slotLength = spriteIndex.length(index);
+        char *paddedPNG = NULL;
+        enum SpriteEditorReturn result = SER_SUCCESS;
+        if (it.value().isEmpty()) {
+            paddedPNG = (char*) malloc(slotLength);
+            if (paddedPNG != NULL) {
+                memcpy(paddedPNG, inputFileArray.constData() + spriteIndex.offset(index), slotLength);
+            } else {
+                result = SER_ERROR_INTERNAL;
+            }
+        } else {
+            paddedPNG = getReplacementPNG(it.value(), slotLength, &result);
+            if ((paddedPNG != NULL) && !isValidSlot(paddedPNG, slotLength)) {
+                free(paddedPNG);
+                paddedPNG = NULL;
+                result = SER_ERROR_VERIFY;
+            }
+        }
+        if (paddedPNG == NULL) {
+            if (firstError == SER_SUCCESS) {
+                firstError = result;
+                *errorIndex = index;
+            }
+            continue;
+        }
+        bool isWritten = outputFile.seek(spriteIndex.offset(index)) && (outputFile.write(paddedPNG, slotLength) == slotLength);
+        free(paddedPNG);
+        if (!isWritten) {
+            outputFile.close();
+            return SER_ERROR_DAT_OUTPUT;
+        }
+    }
+
+    if (!outputFile.flush()) {
+        outputFile.close();
+        return SER_ERROR_DAT_OUTPUT;
+    }
+    outputFile.close();
+    return firstError;
+}
+
+
+// Returns the replacement padded to the slot length, or NULL with the reason in result.
+// Replacements which are too large are losslessly shrunk to fit where possible.
+char *SpriteEditor::getReplacementPNG(const QByteArray &pngArray, int slotLength, enum SpriteEditorReturn *result) const
+{
+    // Padding goes in front of the trailing IEND, so anything shorter than a header and an
+    // IEND, such as a file still being saved, can't be padded.
+    if ((pngArray.size() < PNG_HEADER_LENGTH + IEND_SIZE) || (memcmp(pngArray.constData(), pngHeader, PNG_HEADER_LENGTH) != 0)) {
+        *result = SER_ERROR_INPUT_PNG;
+        return NULL;
+    }
+    QByteArray replacement = pngArray;
+    if (!PNGFitter::fitsSlot(replacement.size(), slotLength)) {
+        replacement = PNGFitter::fit(pngArray, slotLength);
+        if (replacement.isEmpty()) {
+            *result = SER_ERROR_PNG_SIZE;
+            return NULL;
+        }
+    }
+    char *paddedPNG = getPaddedPNG(replacement, slotLength);
+    if (paddedPNG == NULL) {
+        *result = SER_ERROR_INPUT_PNG;
+        return NULL;
+    }
+    *result = SER_SUCCESS;
+    return paddedPNG;
+}
+
+
+char *SpriteEditor::getPaddedPNG(const QByteArray &array, int length) const
+{
+    char *output = (char*) malloc(length);
+    if (output == NULL) {
+        return NULL;
+    }
+    if (array.size() == length) {
+        memcpy(output, array.constData(), length);
+        return output;
+    }
+    int index = array.size() - IEND_SIZE;
+    memcpy(output, array.constData(), index);
+    int overallPaddingAmount = length - array.size();
+    uint32_t internalPaddingAmount = overallPaddingAmount - 12;
+    uint32_t internalBigEndian = qToBigEndian<quint32>(internalPaddingAmount);
+    memcpy(output + index, &internalBigEndian, sizeof(uint32_t));
+    index += sizeof(uint32_t);
+    output[index] = 't';
+    index++;
+    output[index] = 'E';
+    index++;
+    output[index] = 'X';
+    index++;
+    output[index] = 't';
+    index++;
+    output[index] = 'a';
+    index++;
+    output[index] = 0;
+    index++;
+    for (uint32_t i = 0; i < internalPaddingAmount - 2; i++) {
+        output[index] = 'a';
+        index++;
+    }
+    // Calculate CRC.
+    uint32_t crcLittleEndian = crc32::calc_crc_32_fast((unsigned char*) output + array.size() - IEND_SIZE, overallPaddingAmount - 4);
+    uint32_t crcBigEndian = qToBigEndian<quint32>(crcLittleEndian);
+    memcpy(output + index, &crcBigEndian, sizeof(uint32_t));
+    // Append IEND.
+    memcpy(output + length - IEND_SIZE, array.constData() + array.size() - IEND_SIZE, IEND_SIZE);
+    return output;
+}
+
+// Writes the patched and padded PNG straight into its slot of the output, returns false if
+// the patch doesn't leave room for the padding chunk.
+bool SpriteEditor::writePaddedXorPNG(char *output, const uint8_t *originalPNG, const uint8_t *xorArray, int xorLength, int outputLength) const
+{
+    if (outputLength < xorLength + IEND_SIZE + MINIMUM_PAD_AMOUNT) {
+        return false;
+    }
+
+    // Xor and copy data.
+    for (int i = 0; i < xorLength; i++) {
+        output[i] = originalPNG[i] ^ xorArray[i];
+    }
+
+    int index = xorLength;
+    int overallPaddingAmount = outputLength - xorLength - IEND_SIZE;
+    uint32_t internalPaddingAmount = overallPaddingAmount - 12;
+    uint32_t internalBigEndian = qToBigEndian<quint32>(internalPaddingAmount);
+    memcpy(output + index, &internalBigEndian, sizeof(uint32_t));
+    index += sizeof(uint32_t);
+    output[index] = 't';
+    index++;
+    output[index] = 'E';
+    index++;
+    output[index] = 'X';
+    index++;
+    output[index] = 't';
+    index++;
+    output[index] = 'a';
+    index++;
+    output[index] = 0;
+    index++;
+    for (uint32_t i = 0; i < internalPaddingAmount - 2; i++) {
+        output[index] = 'a';
+        index++;
+    }
+    // Calculate CRC.
+    uint32_t crcLittleEndian = crc32::calc_crc_32_fast((unsigned char*) output + xorLength, overallPaddingAmount - 4);
+    uint32_t crcBigEndian = qToBigEndian<quint32>(crcLittleEndian);
+    memcpy(output + index, &crcBigEndian, sizeof(uint32_t));
+    // Append IEND.
+    memcpy(output + outputLength - IEND_SIZE, originalPNG + outputLength - IEND_SIZE, IEND_SIZE);
+    return true;
+}
+
+
+// A changed slot must hold one complete PNG which ends exactly at the end of the slot, with
+// every chunk CRC correct. Otherwise the next index of the output would be different.
+bool SpriteEditor::isValidSlot(const char *slotData, int slotLength)
+{
+    if ((slotLength < PNG_HEADER_LENGTH) || (memcmp(slotData, pngHeader, PNG_HEADER_LENGTH) != 0)) {
+        return false;
+    }
+    QByteArray slot = QByteArray::fromRawData(slotData, slotLength);
+    int index = PNG_HEADER_LENGTH;
+    bool isFirst = true;
+    while (index < slotLength) {
+        uint32_t chunkType;
+        int chunkLength;
+        if (!SpriteIndex::processChunk(slot, index, &chunkType, &chunkLength)) {
+            return false;
+        }
+        if (isFirst && (chunkType != PNG_IHDR)) {
+            return false;
+        }
+        isFirst = false;
+        // The CRC covers the chunk type and data. The padding chunk written by getPaddedPNG and
+        // writePaddedXorPNG, a tEXt right before IEND, has always included the length as well.
+        uint32_t storedCRC;
+        memcpy(&storedCRC, slotData + index + chunkLength - sizeof(uint32_t), sizeof(uint32_t));
+        storedCRC = qFromBigEndian<quint32>(storedCRC);
+        const unsigned char *chunk = (const unsigned char *) slotData + index;
+        if (crc32::calc_crc_32_fast(chunk + sizeof(uint32_t), chunkLength - 2 * sizeof(uint32_t)) != storedCRC) {
+            bool isPadding = (chunkType == PNG_tEXt) && (index + chunkLength == slotLength - IEND_SIZE);
+            if (!isPadding || (crc32::calc_crc_32_fast(chunk, chunkLength - sizeof(uint32_t)) != storedCRC)) {
+                return false;
+            }
+        }
+        index += chunkLength;
+        if (chunkType == PNG_IEND) {
+            return index == slotLength;
+        }
+    }
+    return false;
+}
+
+
+// Applies every XOR patch of a set in parallel. Slots never overlap, so each patch writes
+// straight into its own range of the output. This is also the version check: a patch only
+// yields a valid PNG, with correct chunk CRCs, on the slot it was made from, so any other
+// build fails with SER_ERROR_UNKNOWN_VERSION before anything is written out. The error reported is that of the first failing patch
+// in set order, whichever thread found it.
+template <typename Indices, typename Data, typename Lengths>
+static enum SpriteEditorReturn applyXorPatches(const SpriteEditor *spriteEditor, char *outputData, const QByteArray &inputFileArray, const SpriteIndex &spriteIndex,
+                                               const Indices &indices, const Data &data, const Lengths &lengths, int count)
+{
+    std::vector<int> patches(count);
+    for (int i = 0; i < count; i++) {
+        patches[i] = i;
+    }
+    std::vector<enum SpriteEditorReturn> results(count, SER_SUCCESS);
+    QtConcurrent::blockingMap(patches, [&](int &i) {
+        uint32_t index = indices[i];
+        if (index >= spriteIndex.size()) {
+            results[i] = SER_ERROR_INTERNAL;
+            return;
+        }
+        const uint8_t *originalPNG = (const uint8_t *) inputFileArray.constData() + spriteIndex.offset(index);
+        char *slotData = outputData + spriteIndex.offset(index);
+        if (!spriteEditor->writePaddedXorPNG(slotData, originalPNG, data[i], lengths[i], spriteIndex.length(index))) {
+            results[i] = SER_ERROR_INTERNAL;
+        } else if (!SpriteEditor::isValidSlot(slotData, spriteIndex.length(index))) {
+            results[i] = SER_ERROR_UNKNOWN_VERSION;
+        }
+    });
+    for (int i = 0; i < count; i++) {
+        if (results[i] != SER_SUCCESS) {
+            return results[i];
+        }
+    }
+    return SER_SUCCESS;
+}
+
+
+
+enum SpriteEditorReturn SpriteEditor::createInvisible(QString inputFilename, QString outputFilename, QString *errorExtra) const
+{
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    enum SpriteEditorReturn result = loadInput(inputFilename, &inputFileArray, &spriteIndex);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    return createInvisible(inputFileArray, spriteIndex, outputFilename, errorExtra);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::createInvisible(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, QString *errorExtra) const
+{
+    char *outputData = (char*) malloc(inputFileArray.size());
+    if (outputData == NULL) {
+        return SER_ERROR_INTERNAL;
+    }
+    memcpy(outputData, inputFileArray.constData(), inputFileArray.size());
+
+    enum SpriteEditorReturn result = applyXorPatches(this, outputData, inputFileArray, spriteIndex, invisibleIndices, invisibleData, invisibleLengths, invisibleCount);
+    if (result != SER_SUCCESS) {
+        free(outputData);
+        return result;
+    }
+    result = verifyOutput(inputFileArray, spriteIndex, outputData, errorExtra);
+    if (result != SER_SUCCESS) {
+        free(outputData);
+        return result;
+    }
+
+    bool isWritten = DatWriter::write(outputFilename, outputData, GAMEDATA_DAT_LENGTH, useDirectIO);
+    free(outputData);
+    return isWritten ? SER_SUCCESS : SER_ERROR_DAT_OUTPUT;
+}
+
+
+enum SpriteEditorReturn SpriteEditor::createInvisibleTrails(QString inputFilename, QString outputFilename, QString *errorExtra) const
+{
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    enum SpriteEditorReturn result = loadInput(inputFilename, &inputFileArray, &spriteIndex);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    return createInvisibleTrails(inputFileArray, spriteIndex, outputFilename, errorExtra);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::createInvisibleTrails(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, QString *errorExtra) const
+{
+    char *outputData = (char*) malloc(inputFileArray.size());
+    if (outputData == NULL) {
+        return SER_ERROR_INTERNAL;
+    }
+    memcpy(outputData, inputFileArray.constData(), inputFileArray.size());
+
+    enum SpriteEditorReturn result = applyXorPatches(this, outputData, inputFileArray, spriteIndex, invisibleTrailsIndices, invisibleTrailsData, invisibleTrailsLengths, invisibleTrailsCount);
+    if (result != SER_SUCCESS) {
+        free(outputData);
+        return result;
+    }
+    result = verifyOutput(inputFileArray, spriteIndex, outputData, errorExtra);
+    if (result != SER_SUCCESS) {
+        free(outputData);
+        return result;
+    }
+
+    bool isWritten = DatWriter::write(outputFilename, outputData, GAMEDATA_DAT_LENGTH, useDirectIO);
+    free(outputData);
+    return isWritten ? SER_SUCCESS : SER_ERROR_DAT_OUTPUT;
+}
+
+
+enum SpriteEditorReturn SpriteEditor::verifyOutput(QString inputFilename, QString outputFilename, QString *errorExtra) const
+{
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    enum SpriteEditorReturn result = loadInput(inputFilename, &inputFileArray, &spriteIndex);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    QFile outputFile(outputFilename);
+    if (!outputFile.open(QIODevice::ReadOnly)) {
+        return SER_ERROR_DAT_OUTPUT;
+    }
+    QByteArray outputFileArray = outputFile.readAll();
+    outputFile.close();
+    if (outputFileArray.size() != inputFileArray.size()) {
+        return SER_ERROR_VERIFY;
+    }
+    return verifyOutput(inputFileArray, spriteIndex, outputFileArray.constData(), errorExtra);
+}
+
+
+// Checks a generated .dat has the layout of its input: every byte outside the slots is
+// unchanged and every changed slot is a valid PNG filling it exactly. Slots which are the
+// same as the input are not checked further. Runs in parallel over the slots, the failing
+// ones are listed in errorExtra.
+enum SpriteEditorReturn SpriteEditor::verifyOutput(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, const char *outputData, QString *errorExtra) const
+{
+    const char *inputData = inputFileArray.constData();
+    std::vector<uint32_t> spriteIndices(spriteIndex.size());
+    for (uint32_t i = 0; i < spriteIndex.size(); i++) {
+        spriteIndices[i] = i;
+    }
+    // Each slot also checks the gap between it and the previous slot.
+    std::vector<char> isFailed(spriteIndex.size(), false);
+    QtConcurrent::blockingMap(spriteIndices, [&](uint32_t &i) {
+        int gapStart = (i == 0) ? 0 : spriteIndex.offset(i - 1) + spriteIndex.length(i - 1);
+        int offset = spriteIndex.offset(i);
+        int length = spriteIndex.length(i);
+        if (memcmp(inputData + gapStart, outputData + gapStart, offset - gapStart) != 0) {
+            isFailed[i] = true;
+            return;
+        }
+        if (memcmp(inputData + offset, outputData + offset, length) == 0) {
+            return;
+        }
+        isFailed[i] = !isValidSlot(outputData + offset, length);
+    });
+
+    QStringList failedSprites;
+    for (uint32_t i = 0; i < spriteIndex.size(); i++) {
+        if (isFailed[i]) {
+            failedSprites.append("image" + QString::number(i) + ".png");
+        }
+    }
+    int tailStart = spriteIndex.isEmpty() ? 0 : spriteIndex.offset(spriteIndex.size() - 1) + spriteIndex.length(spriteIndex.size() - 1);
+    if (memcmp(inputData + tailStart, outputData + tailStart, inputFileArray.size() - tailStart) != 0) {
+        failedSprites.append("data after the last sprite");
+    }
+    if (failedSprites.isEmpty()) {
+        return SER_SUCCESS;
+    }
+    if (errorExtra != NULL) {
+        int failedCount = failedSprites.size();
+        if (failedCount > VERIFY_REPORT_LIMIT) {
+            failedSprites = failedSprites.mid(0, VERIFY_REPORT_LIMIT);
+            failedSprites.append(QString("and %1 more").arg(failedCount - VERIFY_REPORT_LIMIT));
+        }
+        *errorExtra = failedSprites.join(", ");
+    }
+    return SER_ERROR_VERIFY;
+}
+
+
+// Writes only the slots which differ between the original and a packed .dat, so mods
+// can be distributed without the full file.
+enum SpriteEditorReturn SpriteEditor::createPatch(QString inputFilename, QString packedFilename, QString patchFilename, bool compress) const
+{
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    enum SpriteEditorReturn result = loadInput(inputFilename, &inputFileArray, &spriteIndex);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    return createPatch(inputFileArray, spriteIndex, packedFilename, patchFilename, compress);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::createPatch(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString packedFilename, QString patchFilename, bool compress) const
+{
+    QFile packedFile(packedFilename);
+    if (!packedFile.open(QIODevice::ReadOnly)) {
+        return SER_ERROR_INPUT_FILE;
+    }
+    QByteArray packedFileArray = packedFile.readAll();
+    packedFile.close();
+    if (packedFileArray.length() != GAMEDATA_DAT_LENGTH) {
+        return SER_ERROR_INPUT_FILE;
+    }
+
+    const char *originalData = inputFileArray.constData();
+    const char *packedData = packedFileArray.constData();
+    QByteArray body;
+    QDataStream bodyStream(&body, QIODevice::WriteOnly);
+    uint32_t entryCount = 0;
+    int previousEnd = 0;
+    for (uint32_t i = 0; i < spriteIndex.size(); i++) {
+        // Anything outside of the slots must be untouched, a patch can't describe it.
+        if (memcmp(originalData + previousEnd, packedData + previousEnd, spriteIndex.offset(i) - previousEnd) != 0) {
+            return SER_ERROR_PATCH_MISMATCH;
+        }
+        previousEnd = spriteIndex.offset(i) + spriteIndex.length(i);
+        if (memcmp(originalData + spriteIndex.offset(i), packedData + spriteIndex.offset(i), spriteIndex.length(i)) == 0) {
+            continue;
+        }
+        quint32 originalCRC = crc32::calc_crc_32_fast((const unsigned char *) originalData + spriteIndex.offset(i), spriteIndex.length(i));
+        bodyStream << (quint32) i << (quint32) spriteIndex.offset(i) << (quint32) spriteIndex.length(i) << originalCRC;
+        bodyStream.writeRawData(packedData + spriteIndex.offset(i), spriteIndex.length(i));
+        entryCount++;
+    }
+    if (memcmp(originalData + previousEnd, packedData + previousEnd, GAMEDATA_DAT_LENGTH - previousEnd) != 0) {
+        return SER_ERROR_PATCH_MISMATCH;
+    }
+
+    uint32_t flags = 0;
+    if (compress) {
+        body = qCompress(body, 9);
+        flags |= PATCH_FLAG_COMPRESSED;
+    }
+
+    QFile patchFile(patchFilename);
+    if (!patchFile.open(QIODevice::WriteOnly)) {
+        return SER_ERROR_PATCH_OUTPUT;
+    }
+    QDataStream patchStream(&patchFile);
+    patchStream << (quint32) PATCH_MAGIC << (quint32) PATCH_VERSION << (quint32) flags
+                << (quint32) GAMEDATA_DAT_LENGTH << (quint32) entryCount;
+    int bytesWritten = patchStream.writeRawData(body.constData(), body.size());
+    if ((patchStream.status() != QDataStream::Ok) || (bytesWritten < body.size())) {
+        patchFile.close();
+        return SER_ERROR_PATCH_OUTPUT;
+    }
+    patchFile.close();
+    return SER_SUCCESS;
+}
+
+
+// Writes the input .dat with the patched slots to the output, which may be the input itself.
+// Patching the input itself also counts as overwriting.
+enum SpriteEditorReturn SpriteEditor::applyPatch(QString inputFilename, QString patchFilename, QString outputFilename, bool overwriteFiles) const
+{
+    QFile patchFile(patchFilename);
+    if (!patchFile.open(QIODevice::ReadOnly)) {
+        return SER_ERROR_INPUT_PATCH;
+    }
+    QByteArray patchArray = patchFile.readAll();
+    patchFile.close();
+
+    QDataStream patchStream(patchArray);
+    quint32 magic, version, flags, datLength, entryCount;
+    patchStream >> magic >> version >> flags >> datLength >> entryCount;
+    if ((patchStream.status() != QDataStream::Ok) || (magic != PATCH_MAGIC) ||
+            (version != PATCH_VERSION) || (datLength != GAMEDATA_DAT_LENGTH)) {
+        return SER_ERROR_INPUT_PATCH;
+    }
+    QByteArray body = patchArray.mid(PATCH_HEADER_LENGTH);
+    if (flags & PATCH_FLAG_COMPRESSED) {
+        body = qUncompress(body);
+        if (body.isEmpty() && (entryCount > 0)) {
+            return SER_ERROR_INPUT_PATCH;
+        }
+    }
+
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    enum SpriteEditorReturn result = loadInput(inputFilename, &inputFileArray, &spriteIndex);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+
+    // Parse all entries before touching the output, a bad patch shouldn't leave it half written.
+    std::vector<quint32> slots;
+    std::vector<quint32> originalCRCs;
+    std::vector<quint32> offsets;
+    std::vector<quint32> lengths;
+    std::vector<int> bodyPositions;
+    QDataStream bodyStream(body);
+    for (quint32 i = 0; i < entryCount; i++) {
+        quint32 slot, offset, length, originalCRC;
+        bodyStream >> slot >> offset >> length >> originalCRC;
+        int position = bodyStream.device()->pos();
+        if ((bodyStream.status() != QDataStream::Ok) || (length < PNG_HEADER_LENGTH + IEND_SIZE) ||
+                (offset > datLength - length) || (length > (quint32) (body.size() - position))) {
+            return SER_ERROR_INPUT_PATCH;
+        }
+        slots.push_back(slot);
+        originalCRCs.push_back(originalCRC);
+        offsets.push_back(offset);
+        lengths.push_back(length);
+        bodyPositions.push_back(position);
+        bodyStream.skipRawData(length);
+    }
+
+    // Each entry must name a slot of the input at the same place, holding exactly what the
+    // patch was made from, otherwise this is a different build of the .dat.
+    for (uint32_t i = 0; i < offsets.size(); i++) {
+        if ((slots[i] >= spriteIndex.size()) || ((quint32) spriteIndex.offset(slots[i]) != offsets[i]) ||
+                ((quint32) spriteIndex.length(slots[i]) != lengths[i]) ||
+                (crc32::calc_crc_32_fast((const unsigned char *) inputFileArray.constData() + offsets[i], lengths[i]) != originalCRCs[i])) {
+            return SER_ERROR_PATCH_MISMATCH;
+        }
+        // A truncated or corrupted patch must not write garbage into the slot.
+        if (!isValidSlot(body.constData() + bodyPositions[i], lengths[i])) {
+            return SER_ERROR_INPUT_PATCH;
+        }
+    }
+
+    // The patched .dat is built and verified in memory like any other output, so the file
+    // written is exactly the one checked.
+    QByteArray outputArray(inputFileArray.constData(), inputFileArray.size());
+    char *outputData = outputArray.data();
+    for (uint32_t i = 0; i < offsets.size(); i++) {
+        memcpy(outputData + offsets[i], body.constData() + bodyPositions[i], lengths[i]);
+    }
+    result = verifyOutput(inputFileArray, spriteIndex, outputData, NULL);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+
+    // Only now that the patch is known to fit is an existing output replaced.
+    if (!overwriteFiles && QFileInfo(outputFilename).exists()) {
+        return SER_ERROR_OVERWRITE;
+    }
+    bool isWritten = DatWriter::write(outputFilename, outputData, GAMEDATA_DAT_LENGTH, useDirectIO);
+    return isWritten ? SER_SUCCESS : SER_ERROR_DAT_OUTPUT;
+}
+
+
+// Loads fingerprints either from a database written by exportFingerprints, or by
+// scanning a .dat directly.
+bool SpriteEditor::loadFingerprints(QString filename, std::vector<SpriteFingerprint> *fingerprints) const
+{
+    fingerprints->clear();
+    QFile inputFile(filename);
+    if (!inputFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray inputFileArray = inputFile.readAll();
+    inputFile.close();
+
+    if ((inputFileArray.length() >= (int) sizeof(uint32_t)) && (readBigEndian32(inputFileArray.constData()) == FINGERPRINT_MAGIC)) {
+        QDataStream databaseStream(inputFileArray);
+        quint32 magic, version, count;
+        databaseStream >> magic >> version >> count;
+        if ((databaseStream.status() != QDataStream::Ok) || (version != FINGERPRINT_VERSION)) {
+            return false;
+        }
+        for (quint32 i = 0; i < count; i++) {
+            quint64 hash;
+            quint32 width, height;
+            databaseStream >> hash >> width >> height;
+            if (databaseStream.status() != QDataStream::Ok) {
+                fingerprints->clear();
+                return false;
+            }
+            fingerprints->push_back({hash, width, height});
+        }
+        return true;
+    }
+
+    if (inputFileArray.length() != GAMEDATA_DAT_LENGTH) {
+        return false;
+    }
+    getFingerprints(inputFileArray, SpriteIndex::build(inputFileArray), fingerprints);
+    return fingerprints->size() > 0;
+}
+
+
+void SpriteEditor::getFingerprints(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, std::vector<SpriteFingerprint> *fingerprints) const
+{
+    fingerprints->clear();
+    const char *data = inputFileArray.constData();
+    for (uint32_t i = 0; i < spriteIndex.size(); i++) {
+        uint64_t hash = fnv1aHash(data + spriteIndex.offset(i), spriteIndex.length(i));
+        fingerprints->push_back({hash, spriteIndex.width(i), spriteIndex.height(i)});
+    }
+}
+
+
+enum SpriteEditorReturn SpriteEditor::exportFingerprints(QString inputFilename, QString databaseFilename) const
+{
+    std::vector<SpriteFingerprint> fingerprints;
+    if (!loadFingerprints(inputFilename, &fingerprints)) {
+        return SER_ERROR_INPUT_FILE;
+    }
+    return writeFingerprints(fingerprints, databaseFilename);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::exportFingerprints(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString databaseFilename) const
+{
+    std::vector<SpriteFingerprint> fingerprints;
+    getFingerprints(inputFileArray, spriteIndex, &fingerprints);
+    return writeFingerprints(fingerprints, databaseFilename);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::writeFingerprints(const std::vector<SpriteFingerprint> &fingerprints, QString databaseFilename) const
+{
+    QFile databaseFile(databaseFilename);
+    if (!databaseFile.open(QIODevice::WriteOnly)) {
+        return SER_ERROR_FINGERPRINT_OUTPUT;
+    }
+    QDataStream databaseStream(&databaseFile);
+    databaseStream << (quint32) FINGERPRINT_MAGIC << (quint32) FINGERPRINT_VERSION << (quint32) fingerprints.size();
+    for (uint32_t i = 0; i < fingerprints.size(); i++) {
+        databaseStream << (quint64) fingerprints[i].hash << (quint32) fingerprints[i].width << (quint32) fingerprints[i].height;
+    }
+    if (databaseStream.status() != QDataStream::Ok) {
+        databaseFile.close();
+        return SER_ERROR_FINGERPRINT_OUTPUT;
+    }
+    databaseFile.close();
+    return SER_SUCCESS;
+}
+
+
+// Copies every imageN.png in the input directory to the slot with the same contents in the
+// new version. Identical sprites are matched in order of appearance. Sprites with no match
+// are skipped and listed in errorExtra.
+enum SpriteEditorReturn SpriteEditor::remapSprites(QString oldFilename, QString newFilename, QString inputDirectory, QString outputDirectory, bool overwriteFiles, QString *errorExtra) const
+{
+    std::vector<SpriteFingerprint> oldFingerprints;
+    std::vector<SpriteFingerprint> newFingerprints;
+    if (!loadFingerprints(oldFilename, &oldFingerprints)) {
+        return SER_ERROR_INPUT_FINGERPRINTS;
+    }
+    if (!loadFingerprints(newFilename, &newFingerprints)) {
+        return SER_ERROR_INPUT_FINGERPRINTS;
+    }
+
+    QDir inputDir(inputDirectory);
+    if (!inputDir.exists()) {
+        return SER_ERROR_INPUT_DIR;
+    }
+    QDir outputDir(outputDirectory);
+    if (!outputDir.exists() || (outputDir.absolutePath() == inputDir.absolutePath())) {
+        return SER_ERROR_OUTPUT_DIR;
+    }
+
+    // Hash index of the new version, each hash maps to its slots in order.
+    QHash<quint64, std::vector<uint32_t>> newSlots;
+    newSlots.reserve(newFingerprints.size());
+    for (uint32_t i = 0; i < newFingerprints.size(); i++) {
+        newSlots[newFingerprints[i].hash].push_back(i);
+    }
+    std::vector<int> oldToNew(oldFingerprints.size(), -1);
+    QHash<quint64, uint32_t> usedCounts;
+    for (uint32_t i = 0; i < oldFingerprints.size(); i++) {
+        auto found = newSlots.constFind(oldFingerprints[i].hash);
+        if (found == newSlots.constEnd()) {
+            continue;
+        }
+        uint32_t &used = usedCounts[oldFingerprints[i].hash];
+        if (used < found->size()) {
+            uint32_t newIndex = (*found)[used];
+            if ((newFingerprints[newIndex].width == oldFingerprints[i].width) &&
+                    (newFingerprints[newIndex].height == oldFingerprints[i].height)) {
+                oldToNew[i] = newIndex;
+            }
+            used++;
+        }
+    }
+
+    QStringList filters;
+    QStringList fileList = inputDir.entryList(filters, QDir::Files, QDir::NoSort);
+    std::vector<QString> sourceFiles;
+    std::vector<QString> targetFiles;
+    QStringList unmatched;
+    for (int i = 0; i < fileList.size(); i++) {
+        QString filename = fileList[i];
+        if (filename.startsWith("image") && filename.endsWith(".png")) {
+            QString numberString = filename;
+            numberString.remove("image");
+            numberString.remove(".png");
+            bool validNumber;
+            uint32_t index = numberString.toUInt(&validNumber);
+            if (!validNumber) {
+                continue;
+            }
+            if ((index >= oldToNew.size()) || (oldToNew[index] == -1)) {
+                unmatched.append(filename);
+                continue;
+            }
+            sourceFiles.push_back(inputDir.absoluteFilePath(filename));
+            targetFiles.push_back(outputDir.absoluteFilePath("image" + QString::number(oldToNew[index]) + ".png"));
+        }
+    }
+
+    if (!overwriteFiles) {
+        for (uint32_t i = 0; i < targetFiles.size(); i++) {
+            if (QFileInfo(targetFiles[i]).exists()) {
+                return SER_ERROR_OVERWRITE;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < targetFiles.size(); i++) {
+        if (QFile::exists(targetFiles[i]) && !QFile::remove(targetFiles[i])) {
+            return SER_ERROR_PNG_OUTPUT;
+        }
+        if (!QFile::copy(sourceFiles[i], targetFiles[i])) {
+            return SER_ERROR_PNG_OUTPUT;
+        }
+    }
+
+    if (unmatched.size() > 0) {
+        *errorExtra = unmatched.join(", ");
+        return SER_ERROR_REMAP_UNMATCHED;
+    }
+    return SER_SUCCESS;
+}
+
+
+// Decodes every sprite and packs them into atlasN.png files, with atlas.json mapping each
+// sprite index to its atlas and rectangle. Sprites which fail to decode are left out.
+enum SpriteEditorReturn SpriteEditor::exportAtlases(QString inputFilename, QString outputDirectory, int atlasSize, bool overwriteFiles) const
+{
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    enum SpriteEditorReturn result = loadInput(inputFilename, &inputFileArray, &spriteIndex);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    return exportAtlases(inputFileArray, spriteIndex, outputDirectory, atlasSize, overwriteFiles);
+}
+
+
+enum SpriteEditorReturn SpriteEditor::exportAtlases(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputDirectory, int atlasSize, bool overwriteFiles) const
+{
+    QDir directory(outputDirectory);
+    if (!directory.exists()) {
+        return SER_ERROR_OUTPUT_DIR;
+    }
+
+    // Decode each sprite once, in parallel.
+    const char *data = inputFileArray.constData();
+    uint32_t spriteCount = spriteIndex.size();
+    std::vector<QImage> images(spriteCount);
+    std::vector<uint32_t> spriteIndices(spriteCount);
+    for (uint32_t i = 0; i < spriteCount; i++) {
+        spriteIndices[i] = i;
+    }
+    QtConcurrent::blockingMap(spriteIndices, [&](uint32_t &i) {
+        images[i] = QImage::fromData((const uchar *) data + spriteIndex.offset(i), spriteIndex.length(i), "PNG");
+    });
+
+    // Tallest first packs best with a skyline.
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < spriteCount; i++) {
+        if (!images[i].isNull()) {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return images[a].height() > images[b].height();
+    });
+
+    std::vector<AtlasPacker> packers;
+    std::vector<int> spriteAtlas(spriteCount, -1);
+    std::vector<int> spriteX(spriteCount, 0);
+    std::vector<int> spriteY(spriteCount, 0);
+    for (uint32_t i : order) {
+        int width = images[i].width() + ATLAS_PADDING;
+        int height = images[i].height() + ATLAS_PADDING;
+        for (uint32_t a = 0; a < packers.size(); a++) {
+            if (packers[a].insert(width, height, &spriteX[i], &spriteY[i])) {
+                spriteAtlas[i] = a;
+                break;
+            }
+        }
+        if (spriteAtlas[i] == -1) {
+            // Sprites larger than the atlas size get an atlas of their own.
+            packers.push_back(AtlasPacker(std::max(atlasSize, width), std::max(atlasSize, height)));
+            packers.back().insert(width, height, &spriteX[i], &spriteY[i]);
+            spriteAtlas[i] = packers.size() - 1;
+        }
+    }
+
+    if (!overwriteFiles) {
+        if (QFileInfo(directory.absoluteFilePath(ATLAS_MANIFEST_FILENAME)).exists()) {
+            return SER_ERROR_OVERWRITE;
+        }
+        for (uint32_t a = 0; a < packers.size(); a++) {
+            QString filename = directory.absoluteFilePath("atlas");
+            filename += QString::number(a) + ".png";
+            if (QFileInfo(filename).exists()) {
+                return SER_ERROR_OVERWRITE;
+            }
+        }
+    }
+
+    // Compose and encode the atlases in parallel, each one is independent.
+    std::vector<std::vector<uint32_t>> atlasSprites(packers.size());
+    for (uint32_t i : order) {
+        atlasSprites[spriteAtlas[i]].push_back(i);
+    }
+    std::vector<uint32_t> atlasIndices(packers.size());
+    for (uint32_t a = 0; a < packers.size(); a++) {
+        atlasIndices[a] = a;
+    }
+    std::vector<char> atlasSaved(packers.size(), 0);
+    QtConcurrent::blockingMap(atlasIndices, [&](uint32_t &a) {
+        QImage atlas(packers[a].usedWidth(), packers[a].usedHeight(), QImage::Format_ARGB32);
+        atlas.fill(Qt::transparent);
+        QPainter painter(&atlas);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (uint32_t i : atlasSprites[a]) {
+            painter.drawImage(spriteX[i], spriteY[i], images[i]);
+        }
+        painter.end();
+        QString filename = directory.absoluteFilePath("atlas");
+        filename += QString::number(a) + ".png";
+        atlasSaved[a] = atlas.save(filename, "PNG");
+    });
+    for (uint32_t a = 0; a < packers.size(); a++) {
+        if (!atlasSaved[a]) {
+            return SER_ERROR_PNG_OUTPUT;
+        }
+    }
+
+    QJsonArray atlasArray;
+    for (uint32_t a = 0; a < packers.size(); a++) {
+        QJsonObject atlasObject;
+        atlasObject["file"] = "atlas" + QString::number(a) + ".png";
+        atlasObject["width"] = packers[a].usedWidth();
+        atlasObject["height"] = packers[a].usedHeight();
+        atlasArray.append(atlasObject);
+    }
+    QJsonArray spriteArray;
+    for (uint32_t i = 0; i < spriteCount; i++) {
+        if (spriteAtlas[i] == -1) {
+            continue;
+        }
+        QJsonObject spriteObject;
+        spriteObject["index"] = (int) i;
+        spriteObject["atlas"] = spriteAtlas[i];
+        spriteObject["x"] = spriteX[i];
+        spriteObject["y"] = spriteY[i];
+        spriteObject["width"] = images[i].width();
+        spriteObject["height"] = images[i].height();
+        spriteArray.append(spriteObject);
+    }
+    QJsonObject manifest;
+    manifest["atlases"] = atlasArray;
+    manifest["sprites"] = spriteArray;
+
+    QFile manifestFile(directory.absoluteFilePath(ATLAS_MANIFEST_FILENAME));
+    if (!manifestFile.open(QIODevice::WriteOnly)) {
+        return SER_ERROR_PNG_OUTPUT;
+    }
+    QByteArray manifestArray = QJsonDocument(manifest).toJson(QJsonDocument::Compact);
+    if (manifestFile.write(manifestArray) < manifestArray.size()) {
+        manifestFile.close();
+        return SER_ERROR_PNG_OUTPUT;
+    }
+    manifestFile.close();
+    return SER_SUCCESS;
+}
+
+
+enum SpriteEditorReturn SpriteEditor::exportCatalog(QString inputFilename, QString catalogFilename) const
+{
+    QByteArray inputFileArray;
+    SpriteIndex spriteIndex;
+    enum SpriteEditorReturn result = loadInput(inputFilename, &inputFileArray, &spriteIndex);
+    if (result != SER_SUCCESS) {
+        return result;
+    }
+    return exportCatalog(spriteIndex, catalogFilename);
+}
+
+
+// Writes the metadata of every sprite, as JSON if the filename ends in .json and in the
+// binary catalog format otherwise.
+enum SpriteEditorReturn SpriteEditor::exportCatalog(const SpriteIndex &spriteIndex, QString catalogFilename) const
+{
+    QByteArray catalog;
+    if (catalogFilename.endsWith(".json", Qt::CaseInsensitive)) {
+        catalog = spriteIndex.toJson();
+    } else {
+        catalog = spriteIndex.toCatalog();
+    }
+
+    QFile catalogFile(catalogFilename);
+    if (!catalogFile.open(QIODevice::WriteOnly)) {
+        return SER_ERROR_CATALOG_OUTPUT;
+    }
+    if (catalogFile.write(catalog) < catalog.size()) {
+        catalogFile.close();
+        return SER_ERROR_CATALOG_OUTPUT;
+    }
+    catalogFile.close();
+    return SER_SUCCESS;
+}
+
+
+// Writes the selected sprites into a single archive instead of loose files.
+enum SpriteEditorReturn SpriteEditor::unpackSpritesToArchive(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString archiveFilename, bool overwriteFiles, const SpriteFilter &filter, bool compress) const
+{
+    if (!overwriteFiles && QFileInfo(archiveFilename).exists()) {
+        return SER_ERROR_OVERWRITE;
+    }
+
+    SpriteArchive archive;
+    if (!archive.create(archiveFilename)) {
+        return SER_ERROR_PNG_OUTPUT;
+    }
+    const char *data = inputFileArray.constData();
+    for (uint32_t i = 0; i < spriteIndex.size(); i++) {
+        if (!filter.matches(spriteIndex, i)) {
+            continue;
+        }
+        if (!archive.append(i, data + spriteIndex.offset(i), spriteIndex.length(i), compress)) {
+            archive.cancel();
+            return SER_ERROR_PNG_OUTPUT;
+        }
+    }
+    if (!archive.finish()) {
+        return SER_ERROR_PNG_OUTPUT;
+    }
+    return SER_SUCCESS;
+}
@@ -0,0 +1,92 @@
+#ifndef SPRITEEDITOR_H
+#define SPRITEEDITOR_H
+
+#include "spriteindex.h"
+#include "spritefilter.h"
+
+#include <QDir>
+#include <QImage>
+#include <QIODevice>
+#include <QMap>
+#include <QString>
+#include <vector>
+
+#define GAMEDATA_DAT_LENGTH 95044834
+enum SpriteEditorReturn {SER_SUCCESS, SER_ERROR_INPUT_FILE,
+                         SER_ERROR_OUTPUT_DIR, SER_ERROR_PNG_OUTPUT,
+                         SER_ERROR_INPUT_DIR, SER_ERROR_OVERWRITE,
+                         SER_ERROR_INTERNAL, SER_ERROR_INPUT_PNG,
+                         SER_ERROR_PNG_SIZE, SER_ERROR_DAT_OUTPUT,
+                         SER_ERROR_INPUT_PATCH, SER_ERROR_PATCH_OUTPUT,
+                         SER_ERROR_PATCH_MISMATCH, SER_ERROR_INPUT_FINGERPRINTS,
+                         SER_ERROR_FINGERPRINT_OUTPUT, SER_ERROR_REMAP_UNMATCHED,
+                         SER_ERROR_CATALOG_OUTPUT, SER_ERROR_INPUT_ARCHIVE,
+                         SER_ERROR_UNKNOWN_VERSION, SER_ERROR_VERIFY};
+
+struct SpriteFingerprint {
+    uint64_t hash;
+    uint32_t width;
+    uint32_t height;
+};
+
+
+
+class SpriteEditor
+{
+public:
+    SpriteEditor();
+    void setDirectIO(bool directIO);
+    enum SpriteEditorReturn loadInput(QString inputFilename, QByteArray *inputFileArray, SpriteIndex *spriteIndex) const;
+    enum SpriteEditorReturn loadInput(const char *data, int length, QByteArray *inputFileArray, SpriteIndex *spriteIndex) const;
+
+    // In-memory API, nothing here touches the disk.
+    QByteArray getSprite(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, uint32_t index) const;
+    enum SpriteEditorReturn packSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, const QMap<uint32_t, QByteArray> &replacements, QByteArray *outputArray, uint32_t *errorIndex, QString *errorExtra) const;
+    enum SpriteEditorReturn packSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, const QMap<uint32_t, QImage> &replacements, QByteArray *outputArray, uint32_t *errorIndex, QString *errorExtra) const;
+
+    enum SpriteEditorReturn unpackSprites(QString inputFilename, QString outputDirectory, bool overwriteFiles) const;
+    enum SpriteEditorReturn unpackSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputDirectory, bool overwriteFiles) const;
+    enum SpriteEditorReturn unpackSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputDirectory, bool overwriteFiles, const SpriteFilter &filter, int shardSize) const;
+    enum SpriteEditorReturn unpackSprites(QIODevice *inputDevice, QString outputDirectory, bool overwriteFiles) const;
+    enum SpriteEditorReturn unpackSpritesToArchive(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString archiveFilename, bool overwriteFiles, const SpriteFilter &filter, bool compress) const;
+    enum SpriteEditorReturn packSprites(QString inputFilename, QString outputFilename, QString inputDirectory, QString *errorExtra) const;
+    enum SpriteEditorReturn packSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, QString inputDirectory, QString *errorExtra) const;
+    enum SpriteEditorReturn packSprites(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, QString inputDirectory, int shardSize, QString *errorExtra) const;
+    enum SpriteEditorReturn createInvisible(QString inputFilename, QString outputFilename, QString *errorExtra) const;
+    enum SpriteEditorReturn createInvisible(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, QString *errorExtra) const;
+    enum SpriteEditorReturn createInvisibleTrails(QString inputFilename, QString outputFilename, QString *errorExtra) const;
+    enum SpriteEditorReturn createInvisibleTrails(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, QString *errorExtra) const;
+    enum SpriteEditorReturn createPatch(QString inputFilename, QString packedFilename, QString patchFilename, bool compress) const;
+    enum SpriteEditorReturn createPatch(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString packedFilename, QString patchFilename, bool compress) const;
+    enum SpriteEditorReturn applyPatch(QString inputFilename, QString patchFilename, QString outputFilename, bool overwriteFiles) const;
+    enum SpriteEditorReturn exportFingerprints(QString inputFilename, QString databaseFilename) const;
+    enum SpriteEditorReturn exportFingerprints(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString databaseFilename) const;
+    enum SpriteEditorReturn exportCatalog(QString inputFilename, QString catalogFilename) const;
+    enum SpriteEditorReturn exportCatalog(const SpriteIndex &spriteIndex, QString catalogFilename) const;
+    enum SpriteEditorReturn exportAtlases(QString inputFilename, QString outputDirectory, int atlasSize, bool overwriteFiles) const;
+    enum SpriteEditorReturn exportAtlases(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputDirectory, int atlasSize, bool overwriteFiles) const;
+    enum SpriteEditorReturn verifyOutput(QString inputFilename, QString outputFilename, QString *errorExtra) const;
+    enum SpriteEditorReturn verifyOutput(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, const char *outputData, QString *errorExtra) const;
+    static bool isValidSlot(const char *slotData, int slotLength);
+    enum SpriteEditorReturn remapSprites(QString oldFilename, QString newFilename, QString inputDirectory, QString outputDirectory, bool overwriteFiles, QString *errorExtra) const;
+
+
+    enum SpriteEditorReturn replaceSpritesFromDirectory(char *outputData, const SpriteIndex &spriteIndex, const QDir &directory, int shardSize, QString *errorExtra) const;
+    enum SpriteEditorReturn replaceSpritesFromShard(char *outputData, const SpriteIndex &spriteIndex, const QDir &directory, uint32_t firstIndex, uint32_t endIndex, QString *errorExtra) const;
+    enum SpriteEditorReturn replaceSpritesFromArchive(char *outputData, const SpriteIndex &spriteIndex, QString archiveFilename, QString *errorExtra) const;
+    enum SpriteEditorReturn replaceSpritesInFile(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, QString outputFilename, const QMap<uint32_t, QByteArray> &replacements, uint32_t *errorIndex) const;
+    enum SpriteEditorReturn replaceSprite(char *outputData, const SpriteIndex &spriteIndex, uint32_t index, const QByteArray &pngArray) const;
+    char *getReplacementPNG(const QByteArray &pngArray, int slotLength, enum SpriteEditorReturn *result) const;
+    QString getSpriteFilename(const QDir &directory, uint32_t index, int shardSize) const;
+    char *getPaddedPNG(const QByteArray &array, int length) const;
+    bool writePaddedXorPNG(char *output, const uint8_t *originalPNG, const uint8_t *xorArray, int xorLength, int outputLength) const;
+    bool loadFingerprints(QString filename, std::vector<SpriteFingerprint> *fingerprints) const;
+    void getFingerprints(const QByteArray &inputFileArray, const SpriteIndex &spriteIndex, std::vector<SpriteFingerprint> *fingerprints) const;
+    enum SpriteEditorReturn writeFingerprints(const std::vector<SpriteFingerprint> &fingerprints, QString databaseFilename) const;
+
+private:
+    // Whether full .dat outputs are written bypassing the page cache, see DatWriter.
+    bool useDirectIO;
+};
+
+#endif // SPRITEEDITOR_H
@@ -0,0 +1,126 @@
+#include "spritefilter.h"
+
+#include <QRegularExpression>
+#include <QStringList>
+
+#define PNG_COLOR_GRAY 0
+#define PNG_COLOR_RGB 2
+#define PNG_COLOR_PALETTE 3
+#define PNG_COLOR_GRAY_ALPHA 4
+#define PNG_COLOR_RGBA 6
+
+SpriteFilter::SpriteFilter()
+{
+    width = -1;
+    height = -1;
+    bitDepth = -1;
+    colorType = -1;
+}
+
+
+static bool parseColorType(QString value, int *colorType)
+{
+    value = value.toLower();
+    if (value == "gray") {
+        *colorType = PNG_COLOR_GRAY;
+    } else if (value == "rgb") {
+        *colorType = PNG_COLOR_RGB;
+    } else if (value == "palette") {
+        *colorType = PNG_COLOR_PALETTE;
+    } else if (value == "grayalpha") {
+        *colorType = PNG_COLOR_GRAY_ALPHA;
+    } else if (value == "rgba") {
+        *colorType = PNG_COLOR_RGBA;
+    } else {
+        bool validNumber;
+        *colorType = value.toUInt(&validNumber);
+        return validNumber;
+    }
+    return true;
+}
+
+
+// Parses terms separated by commas or whitespace. A term is an index "5", a range "5-10",
+// an open range "5-", or one of width=N, height=N, size=WxH, depth=N and color=N, where the
+// color may also be gray, rgb, palette, grayalpha or rgba.
+bool SpriteFilter::parse(QString text, SpriteFilter *filter)
+{
+    SpriteFilter result;
+    QStringList terms = text.split(QRegularExpression("[,\\s]+"), Qt::SkipEmptyParts);
+    for (int i = 0; i < terms.size(); i++) {
+        QString term = terms[i];
+        bool validNumber = true;
+        if (term.contains('=')) {
+            QString key = term.section('=', 0, 0).toLower();
+            QString value = term.section('=', 1);
+            if (key == "width") {
+                result.width = value.toUInt(&validNumber);
+            } else if (key == "height") {
+                result.height = value.toUInt(&validNumber);
+            } else if (key == "size") {
+                bool validHeight;
+                result.width = value.section('x', 0, 0).toUInt(&validNumber);
+                result.height = value.section('x', 1).toUInt(&validHeight);
+                validNumber = validNumber && validHeight;
+            } else if (key == "depth") {
+                result.bitDepth = value.toUInt(&validNumber);
+            } else if (key == "color") {
+                validNumber = parseColorType(value, &result.colorType);
+            } else {
+                return false;
+            }
+        } else if (term.contains('-')) {
+            bool validEnd = true;
+            uint32_t start = term.section('-', 0, 0).toUInt(&validNumber);
+            QString endString = term.section('-', 1);
+            uint32_t end = UINT32_MAX;
+            if (!endString.isEmpty()) {
+                end = endString.toUInt(&validEnd);
+            }
+            if (!validEnd || (end < start)) {
+                return false;
+            }
+            result.ranges.push_back(std::make_pair(start, end));
+        } else {
+            uint32_t index = term.toUInt(&validNumber);
+            result.ranges.push_back(std::make_pair(index, index));
+        }
+        if (!validNumber) {
+            return false;
+        }
+    }
+    *filter = result;
+    return true;
+}
+
+
+bool SpriteFilter::matches(const SpriteIndex &spriteIndex, uint32_t i) const
+{
+    if ((width != -1) && (spriteIndex.width(i) != width)) {
+        return false;
+    }
+    if ((height != -1) && (spriteIndex.height(i) != height)) {
+        return false;
+    }
+    if ((bitDepth != -1) && (spriteIndex.bitDepth(i) != bitDepth)) {
+        return false;
+    }
+    if ((colorType != -1) && (spriteIndex.colorType(i) != colorType)) {
+        return false;
+    }
+    if (ranges.empty()) {
+        return true;
+    }
+    for (uint32_t r = 0; r < ranges.size(); r++) {
+        if ((i >= ranges[r].first) && (i <= ranges[r].second)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool SpriteFilter::isEmpty() const
+{
+    return ranges.empty() && (width == -1) && (height == -1) && (bitDepth == -1) && (colorType == -1);
+}
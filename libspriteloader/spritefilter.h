@@ -0,0 +1,29 @@
+#ifndef SPRITEFILTER_H
+#define SPRITEFILTER_H
+
+#include "spriteindex.h"
+
+#include <QString>
+#include <utility>
+#include <vector>
+
+// Selects sprites by index and IHDR metadata. An empty filter matches every sprite.
+class SpriteFilter
+{
+public:
+    SpriteFilter();
+    static bool parse(QString text, SpriteFilter *filter);
+    bool matches(const SpriteIndex &spriteIndex, uint32_t i) const;
+    bool isEmpty() const;
+
+private:
+    // Inclusive index ranges, any index matches if there are none.
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    // -1 matches any value.
+    int64_t width;
+    int64_t height;
+    int bitDepth;
+    int colorType;
+};
+
+#endif // SPRITEFILTER_H
@@ -0,0 +1,258 @@
+#include "spriteindex.h"
+#include "pngformat.h"
+
+#include <QtEndian>
+#include <QDataStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cassert>
+#include <cstring>
+
+// Catalogs are magic "SLCT", version and count, followed by every field of every sprite.
+#define CATALOG_MAGIC 0x534c4354
+#define CATALOG_VERSION 1
+
+SpriteIndex::SpriteIndex()
+{
+
+}
+
+
+static uint32_t readBigEndian32(const char *data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(uint32_t));
+    return qFromBigEndian<quint32>(value);
+}
+
+
+SpriteIndex SpriteIndex::build(const QByteArray &array)
+{
+    SpriteIndex index;
+    const char *data = array.constData();
+    int startIndex = 0;
+    int pngStart;
+    int pngLength;
+    uint32_t chunkCount;
+    uint32_t slack;
+    bool hasFoundPNG = true;
+    bool shouldContinue = true;
+    while (shouldContinue) {
+        shouldContinue = findPNG(array, startIndex, &hasFoundPNG, &pngStart, &pngLength, &chunkCount, &slack);
+        if (hasFoundPNG) {
+            index.appendSprite(data, pngStart, pngLength, chunkCount, slack);
+        }
+        startIndex = pngStart + pngLength;
+    }
+    return index;
+}
+
+
+// Rebuilds an index from known slot locations, such as a cached layout, without scanning
+// the whole array. Every slot is walked like findPNG would, so the metadata always comes
+// from the array itself. Fails if any slot isn't exactly one PNG.
+bool SpriteIndex::fromLayout(const QByteArray &array, const std::vector<int> &offsets, const std::vector<int> &lengths, SpriteIndex *index)
+{
+    if (offsets.empty() || (offsets.size() != lengths.size())) {
+        return false;
+    }
+    SpriteIndex result;
+    int previousEnd = 0;
+    for (uint32_t i = 0; i < offsets.size(); i++) {
+        int offset = offsets[i];
+        int length = lengths[i];
+        if ((offset < previousEnd) || (length < PNG_HEADER_LENGTH) || (offset > array.size() - length) ||
+                (memcmp(array.constData() + offset, pngHeader, PNG_HEADER_LENGTH) != 0)) {
+            return false;
+        }
+        // Only the slot itself is visible to the walk, so no chunk can run past its end.
+        QByteArray slot = QByteArray::fromRawData(array.constData() + offset, length);
+        int chunkIndex = PNG_HEADER_LENGTH;
+        uint32_t chunkCount = 0;
+        uint32_t slack = 0;
+        uint32_t chunkType = 0;
+        while (chunkType != PNG_IEND) {
+            int chunkLength;
+            if (!processChunk(slot, chunkIndex, &chunkType, &chunkLength) || ((chunkCount == 0) && (chunkType != PNG_IHDR))) {
+                return false;
+            }
+            chunkIndex += chunkLength;
+            chunkCount++;
+            if ((chunkType != PNG_IHDR) && (chunkType != PNG_PLTE) && (chunkType != PNG_IDAT) && (chunkType != PNG_IEND)) {
+                slack += chunkLength;
+            }
+        }
+        if (chunkIndex != length) {
+            return false;
+        }
+        result.appendSprite(array.constData(), offset, length, chunkCount, slack);
+        previousEnd = offset + length;
+    }
+    *index = result;
+    return true;
+}
+
+
+void SpriteIndex::appendSprite(const char *data, int offset, int length, uint32_t chunkCount, uint32_t slack)
+{
+    const char *png = data + offset;
+    offsets.push_back(offset);
+    lengths.push_back(length);
+    chunkCounts.push_back(chunkCount);
+    slacks.push_back(slack);
+    // The IHDR chunk is always present, but may not be full length.
+    if (readBigEndian32(png + IHDR_LENGTH_OFFSET) >= IHDR_DATA_LENGTH) {
+        widths.push_back(readBigEndian32(png + IHDR_WIDTH_OFFSET));
+        heights.push_back(readBigEndian32(png + IHDR_HEIGHT_OFFSET));
+        bitDepths.push_back(png[IHDR_BIT_DEPTH_OFFSET]);
+        colorTypes.push_back(png[IHDR_COLOR_TYPE_OFFSET]);
+        interlaces.push_back(png[IHDR_INTERLACE_OFFSET]);
+    } else {
+        widths.push_back(0);
+        heights.push_back(0);
+        bitDepths.push_back(0);
+        colorTypes.push_back(0);
+        interlaces.push_back(0);
+    }
+}
+
+
+// Returns whether we should continue searching.
+// Always returns a outputIndex and outputLength, which tell us where to skip to.
+// These are a valid PNG if hasFoundPNG == true, otherwise just tell us where to skip to.
+// Also counts the chunks of a found PNG, and how many bytes of it are ancillary chunks.
+bool SpriteIndex::findPNG(const QByteArray &array, int startIndex, bool *hasFoundPNG, int *outputIndex, int *outputLength,
+                          uint32_t *outputChunkCount, uint32_t *outputSlack)
+{
+    *outputChunkCount = 0;
+    *outputSlack = 0;
+    if (startIndex > array.length()) {
+        assert(false);
+    }
+
+    int headerIndex = array.indexOf(pngHeader, startIndex);
+    if (headerIndex == -1) {
+        *hasFoundPNG = false;
+        *outputIndex = array.length();
+        *outputLength = 0;
+        return false;
+    }
+
+    int index = headerIndex + PNG_HEADER_LENGTH;
+    bool isFirst = true;
+    uint32_t chunkType;
+    int chunkLength;
+    while (true) {
+        bool isValidChunk = processChunk(array, index, &chunkType, &chunkLength);
+        if (!isValidChunk) {
+            *hasFoundPNG = false;
+            *outputIndex = headerIndex;
+            *outputLength = PNG_HEADER_LENGTH;
+            return true;
+        }
+        //qDebug() << "    Found chunk: " << chunkType;
+        if (isFirst) {
+            if (chunkType == PNG_IHDR) {
+                isFirst = false;
+            } else {
+                *hasFoundPNG = false;
+                *outputIndex = headerIndex;
+                *outputLength = PNG_HEADER_LENGTH;
+                return true;
+            }
+        }
+        index += chunkLength;
+        (*outputChunkCount)++;
+        if ((chunkType != PNG_IHDR) && (chunkType != PNG_PLTE) && (chunkType != PNG_IDAT) && (chunkType != PNG_IEND)) {
+            *outputSlack += chunkLength;
+        }
+        if (chunkType == PNG_IEND) {
+            *hasFoundPNG = true;
+            *outputIndex = headerIndex;
+            *outputLength = index - headerIndex;
+            return true;
+        }
+    }
+}
+
+// Returns whether we received a valid chunk.
+//
+bool SpriteIndex::processChunk(const QByteArray &array, int startIndex, uint32_t *outputType, int *outputLength)
+{
+    if (startIndex > array.length() - 8) {
+        return false;
+    }
+    const char *data = array.constData();
+
+    uint32_t length;
+    uint32_t type;
+    memcpy(&length, data + startIndex, sizeof(uint32_t));
+    memcpy(&type, data + startIndex + sizeof(uint32_t), sizeof(uint32_t));
+    length = qFromBigEndian<quint32>(length);
+    type = qFromBigEndian<quint32>(type);
+
+    // Check very basic validity.
+    //qDebug() << "    length: " << length << " type: " << type;
+    if (!isValidChunkType(type)) {
+        *outputType = 0;
+        *outputLength = 0;
+        return false;
+    }
+    // Check length for validity. Adds crc, length, type.
+    if (startIndex + (sizeof(uint32_t) * 3) + length > (uint32_t) array.length()) {
+        *outputType = 0;
+        *outputLength = 0;
+        return false;
+    }
+    // Return.
+    *outputType = type;
+    *outputLength = length + (sizeof(uint32_t) * 3);
+    return true;
+}
+
+
+bool SpriteIndex::isValidChunkType(uint32_t type)
+{
+    for (int i = 0; i < PNG_TYPE_COUNT; i++) {
+        if (type == pngTypes[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+QByteArray SpriteIndex::toCatalog() const
+{
+    QByteArray catalog;
+    QDataStream catalogStream(&catalog, QIODevice::WriteOnly);
+    catalogStream << (quint32) CATALOG_MAGIC << (quint32) CATALOG_VERSION << (quint32) size();
+    for (uint32_t i = 0; i < size(); i++) {
+        catalogStream << (qint32) offsets[i] << (qint32) lengths[i] << (quint32) widths[i] << (quint32) heights[i]
+                      << (quint8) bitDepths[i] << (quint8) colorTypes[i] << (quint8) interlaces[i]
+                      << (quint32) chunkCounts[i] << (quint32) slacks[i];
+    }
+    return catalog;
+}
+
+
+QByteArray SpriteIndex::toJson() const
+{
+    QJsonArray spriteArray;
+    for (uint32_t i = 0; i < size(); i++) {
+        QJsonObject spriteObject;
+        spriteObject["index"] = (int) i;
+        spriteObject["offset"] = offsets[i];
+        spriteObject["length"] = lengths[i];
+        spriteObject["width"] = (qint64) widths[i];
+        spriteObject["height"] = (qint64) heights[i];
+        spriteObject["bitDepth"] = bitDepths[i];
+        spriteObject["colorType"] = colorTypes[i];
+        spriteObject["interlace"] = interlaces[i];
+        spriteObject["chunkCount"] = (qint64) chunkCounts[i];
+        spriteObject["slack"] = (qint64) slacks[i];
+        spriteArray.append(spriteObject);
+    }
+    return QJsonDocument(spriteArray).toJson(QJsonDocument::Compact);
+}
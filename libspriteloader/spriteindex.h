@@ -0,0 +1,52 @@
+#ifndef SPRITEINDEX_H
+#define SPRITEINDEX_H
+
+#include <QByteArray>
+#include <cstdint>
+#include <vector>
+
+// Locations and IHDR metadata of every PNG in a .dat, stored as parallel arrays.
+// Built once by scanning and never modified afterwards, so a single index can be
+// shared by concurrent operations on the same data.
+class SpriteIndex
+{
+public:
+    SpriteIndex();
+    static SpriteIndex build(const QByteArray &array);
+    static bool fromLayout(const QByteArray &array, const std::vector<int> &offsets, const std::vector<int> &lengths, SpriteIndex *index);
+    QByteArray toCatalog() const;
+    QByteArray toJson() const;
+
+    uint32_t size() const { return offsets.size(); }
+    bool isEmpty() const { return offsets.empty(); }
+    int offset(uint32_t i) const { return offsets[i]; }
+    int length(uint32_t i) const { return lengths[i]; }
+    uint32_t width(uint32_t i) const { return widths[i]; }
+    uint32_t height(uint32_t i) const { return heights[i]; }
+    uint8_t bitDepth(uint32_t i) const { return bitDepths[i]; }
+    uint8_t colorType(uint32_t i) const { return colorTypes[i]; }
+    uint8_t interlace(uint32_t i) const { return interlaces[i]; }
+    uint32_t chunkCount(uint32_t i) const { return chunkCounts[i]; }
+    uint32_t slack(uint32_t i) const { return slacks[i]; }
+
+    static bool findPNG(const QByteArray &array, int startIndex, bool *hasFoundPNG, int *outputIndex, int *outputLength,
+                        uint32_t *outputChunkCount, uint32_t *outputSlack);
+    static bool processChunk(const QByteArray &array, int startIndex, uint32_t *outputType, int *outputLength);
+    static bool isValidChunkType(uint32_t type);
+
+private:
+    void appendSprite(const char *data, int offset, int length, uint32_t chunkCount, uint32_t slack);
+
+    std::vector<int> offsets;
+    std::vector<int> lengths;
+    std::vector<uint32_t> widths;
+    std::vector<uint32_t> heights;
+    std::vector<uint8_t> bitDepths;
+    std::vector<uint8_t> colorTypes;
+    std::vector<uint8_t> interlaces;
+    std::vector<uint32_t> chunkCounts;
+    // Bytes of the slot taken by ancillary chunks, which a replacement doesn't need to keep.
+    std::vector<uint32_t> slacks;
+};
+
+#endif // SPRITEINDEX_H
@@ -0,0 +1,132 @@
+#include "streamingscanner.h"
+#include "pngformat.h"
+#include "spriteindex.h"
+
+#include <QtEndian>
+#include <algorithm>
+
+#define READ_BLOCK_SIZE (1 << 20)
+#define CHUNK_HEADER_LENGTH 8
+#define CHUNK_OVERHEAD 12
+
+StreamingScanner::StreamingScanner(QIODevice *device, int maximumPNGLength)
+{
+    this->device = device;
+    this->maximumPNGLength = maximumPNGLength;
+    windowOffset = 0;
+    totalRead = 0;
+    position = 0;
+    spriteCount = 0;
+    isEnd = false;
+}
+
+
+// Returns the next PNG, its sprite index and its offset in the input. Returns false once
+// the input is exhausted.
+bool StreamingScanner::next(uint32_t *index, qint64 *offset, QByteArray *png)
+{
+    while (true) {
+        int headerIndex = window.indexOf(pngHeader, position);
+        if (headerIndex == -1) {
+            // Keep the tail in case a header is split across reads.
+            int keep = std::min(window.size() - position, PNG_HEADER_LENGTH - 1);
+            discard(window.size() - keep);
+            if (!fill(window.size() + 1)) {
+                return false;
+            }
+            continue;
+        }
+        // Compact only once a whole block has been consumed, not for every sprite.
+        if (headerIndex > READ_BLOCK_SIZE) {
+            discard(headerIndex);
+            headerIndex = 0;
+        }
+
+        // Walk the chunks the same way SpriteIndex::findPNG does.
+        int chunkIndex = headerIndex + PNG_HEADER_LENGTH;
+        bool isFirst = true;
+        bool isValid = true;
+        bool isComplete = false;
+        while (isValid && !isComplete) {
+            fill(chunkIndex + CHUNK_HEADER_LENGTH);
+            if (window.size() < chunkIndex + CHUNK_HEADER_LENGTH) {
+                isValid = false;
+                break;
+            }
+            // Only a plausible chunk is read in full, so a stray header followed by garbage
+            // can't make the window grow.
+            quint32 length = qFromBigEndian<quint32>((const uchar *) window.constData() + chunkIndex);
+            quint32 type = qFromBigEndian<quint32>((const uchar *) window.constData() + chunkIndex + sizeof(quint32));
+            if (!SpriteIndex::isValidChunkType(type) || ((qint64) chunkIndex - headerIndex + CHUNK_OVERHEAD + length > maximumPNGLength)) {
+                isValid = false;
+                break;
+            }
+            fill(chunkIndex + CHUNK_OVERHEAD + length);
+            uint32_t chunkType;
+            int chunkLength;
+            if (!SpriteIndex::processChunk(window, chunkIndex, &chunkType, &chunkLength)) {
+                isValid = false;
+                break;
+            }
+            if (isFirst && (chunkType != PNG_IHDR)) {
+                isValid = false;
+                break;
+            }
+            isFirst = false;
+            chunkIndex += chunkLength;
+            isComplete = (chunkType == PNG_IEND);
+        }
+
+        if (!isValid) {
+            position = headerIndex + PNG_HEADER_LENGTH;
+            continue;
+        }
+        *index = spriteCount;
+        *offset = windowOffset + headerIndex;
+        *png = window.mid(headerIndex, chunkIndex - headerIndex);
+        spriteCount++;
+        position = chunkIndex;
+        return true;
+    }
+}
+
+
+qint64 StreamingScanner::bytesRead() const
+{
+    return totalRead;
+}
+
+
+// Reads until the window holds at least minimumSize bytes, returns false if the input
+// ended first.
+bool StreamingScanner::fill(int minimumSize)
+{
+    while (window.size() < minimumSize) {
+        if (isEnd) {
+            return false;
+        }
+        QByteArray block = device->read(READ_BLOCK_SIZE);
+        if (block.isEmpty()) {
+            // Sockets and processes may just not have data yet. Files block on read, so for
+            // them waitForReadyRead returns false and an empty read is the end of input.
+            if (!device->waitForReadyRead(-1)) {
+                isEnd = true;
+            }
+            continue;
+        }
+        totalRead += block.size();
+        window.append(block);
+    }
+    return true;
+}
+
+
+void StreamingScanner::discard(int length)
+{
+    if (length <= 0) {
+        return;
+    }
+    window.remove(0, length);
+    windowOffset += length;
+    position = std::max(position - length, 0);
+}
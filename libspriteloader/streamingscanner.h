@@ -0,0 +1,34 @@
+#ifndef STREAMINGSCANNER_H
+#define STREAMINGSCANNER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <cstdint>
+
+// Finds the PNGs of a .dat read sequentially from any device, including pipes, holding only
+// a window of the input in memory. Finds the same PNGs as SpriteIndex::build, except that
+// PNGs longer than the maximum length are treated as invalid, which bounds the window to
+// about that length plus one read block.
+class StreamingScanner
+{
+public:
+    StreamingScanner(QIODevice *device, int maximumPNGLength);
+    bool next(uint32_t *index, qint64 *offset, QByteArray *png);
+    qint64 bytesRead() const;
+
+private:
+    bool fill(int minimumSize);
+    void discard(int length);
+
+    QIODevice *device;
+    int maximumPNGLength;
+    QByteArray window;
+    // Offset in the input of the first byte of the window.
+    qint64 windowOffset;
+    qint64 totalRead;
+    int position;
+    uint32_t spriteCount;
+    bool isEnd;
+};
+
+#endif // STREAMINGSCANNER_H